@@ -2,34 +2,53 @@
 
 in DATA
 {
-    vec3 Position;
-    vec3 Normal;
-    vec3 LocalPosition;
-    vec3 LocalNormal;
+#include "include/data.glsl"
 }
 data_in;
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out uint EntityID;
 
-uniform vec3 uLightPos;
-uniform vec3 uLightColor;
-uniform vec3 uObjectColor;
-uniform vec3 uWireframeColor;
-uniform float uTime;
-uniform float uResolution;
-uniform int uIsWireframe;
+#include "include/uniforms.glsl"
+
+#ifndef FLAT_COLOR
+#include "include/lights.glsl"
+#endif
+
+#ifdef FUNK
+#include "include/noise.glsl"
+#endif
+
+#ifdef WIREFRAME
+#include "include/wireframe.glsl"
+#endif
 
 void main()
 {
+    EntityID = uint(data_in.ID);
+
     if (uIsWireframe == 1)
     {
         FragColor = vec4(uWireframeColor, 1.0);
         return;
     }
 
+#if defined(FLAT_COLOR)
+    FragColor = vec4(vec3(1.0, 0.5, 0.06), 1.0);
+#elif defined(FUNK)
+    float n = snoise(data_in.Position * 3.0) * 0.5 + 0.5;
+    FragColor = vec4(n * uObjectColor, n);
+    FragColor.rgb *= uAmbientLight + GetClusteredLighting(data_in.Position, data_in.Normal);
+#else
     vec3 posNorm = max(vec3(0.0), data_in.LocalNormal);
     vec3 negNorm = min(data_in.LocalNormal, vec3(0.0));
     vec3 normColor = posNorm + abs(negNorm) * 0.7;
 
     FragColor = vec4(normColor * uObjectColor, 1.0);
+    FragColor.rgb *= uAmbientLight + GetClusteredLighting(data_in.Position, data_in.Normal);
+#endif
+
+#ifdef WIREFRAME
+    FragColor = mix(FragColor, vec4(uWireframeColor, 1.0), GetWireframeCoverage(data_in.LocalPosition, 1.0));
+#endif
 }
@@ -5,28 +5,56 @@ layout (location = 1) in vec3 aNormal;
 
 out DATA
 {
-    vec3 Position;
-    vec3 Normal;
-    vec3 LocalPosition;
-    vec3 LocalNormal;
+#include "include/data.glsl"
 } data_out;
 
-uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
-uniform float uTime;
-uniform float uResolution;
-uniform int uID;
-uniform int uIsWireframe;
+#include "include/uniforms.glsl"
+
+#ifdef INDIRECT
+struct DrawData
+{
+    mat4 Model;
+    mat4 Normal;
+    int ID;
+    int FirstIndex;
+    int BaseVertex;
+};
+
+layout (std430, binding = 0) readonly buffer DrawBuffer
+{
+    DrawData uDraws[];
+};
+
+uniform int uDrawOffset; // index of the first draw of this glMultiDrawElementsIndirect call
+#endif
+
+#ifdef WIREFRAME
+flat out ivec2 vTriangleBase; // see include/wireframe.glsl
+#endif
 
 
 void main()
 {
+#ifdef INDIRECT
+    DrawData draw = uDraws[uDrawOffset + gl_DrawID];
+
+	data_out.Position = vec3(draw.Model * vec4(aPosition, 1.0f));
+	data_out.Normal = mat3(draw.Normal) * aNormal;
+    data_out.ID = draw.ID;
+#else
 	data_out.Position = vec3(uModel * vec4(aPosition, 1.0f));
-	data_out.Normal = mat3(transpose(inverse(uModel))) * aNormal;
+	data_out.Normal = mat3(uNormalMatrix) * aNormal;
+    data_out.ID = uID;
+#endif
     data_out.LocalPosition = aPosition;
     data_out.LocalNormal = aNormal;
 
+#if defined(WIREFRAME) && defined(INDIRECT)
+    vTriangleBase = ivec2(draw.FirstIndex, draw.BaseVertex);
+#elif defined(WIREFRAME)
+    vTriangleBase = ivec2(0); // direct draws use the mesh's own buffers
+#endif
+
     if (uIsWireframe == 1) // move vertices towards camera to avoid z-fighting
     {
         vec3 viewDir = (data_out.Position - vec3(inverse(uView)[3]));
@@ -35,4 +63,4 @@ void main()
     }
 
     gl_Position = uProjection * uView * vec4(data_out.Position, 1.0);
-}
\ No newline at end of file
+}
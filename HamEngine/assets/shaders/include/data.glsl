@@ -0,0 +1,6 @@
+// members of the DATA interface block, include it inside the block: out DATA { #include ... } data_out;
+vec3 Position;
+vec3 Normal;
+vec3 LocalPosition;
+vec3 LocalNormal;
+flat int ID; // entity handle, written to the id attachment
@@ -0,0 +1,56 @@
+#pragma once
+// Clustered point lights, binned on the CPU by LightClusters. The grid size must match LightClusters.h
+const uvec3 CLUSTER_GRID = uvec3(16u, 9u, 24u);
+
+struct ClusterLight
+{
+    vec4 PositionRadius; // view space
+    vec4 ColorIntensity;
+};
+
+layout (std430, binding = 3) readonly buffer LightBuffer
+{
+    ClusterLight uLights[];
+};
+
+layout (std430, binding = 4) readonly buffer ClusterBuffer
+{
+    uvec2 uClusters[]; // offset into uLightIndices, count
+};
+
+layout (std430, binding = 5) readonly buffer LightIndexBuffer
+{
+    uint uLightIndices[];
+};
+
+// diffuse light of every point light whose cluster contains this fragment
+vec3 GetClusteredLighting(vec3 worldPosition, vec3 worldNormal)
+{
+    vec3 viewPosition = vec3(uView * vec4(worldPosition, 1.0));
+    vec3 viewNormal = normalize(mat3(uView) * worldNormal);
+
+    vec4 clip = uProjection * vec4(viewPosition, 1.0);
+    vec2 tile = clamp((clip.xy / clip.w * 0.5 + 0.5) * vec2(CLUSTER_GRID.xy), vec2(0.0), vec2(CLUSTER_GRID.xy) - 1.0);
+
+    // the grid's near plane (LightClusters::GetNear), anything in front of it is in slice 0
+    float near = uClusterDepthRange.x;
+    float far = uClusterDepthRange.y;
+    float depth = max(-viewPosition.z, near);
+    float slice = clamp(log(depth / near) / log(far / near) * float(CLUSTER_GRID.z), 0.0, float(CLUSTER_GRID.z - 1u));
+
+    uvec2 cluster = uClusters[(uint(slice) * CLUSTER_GRID.y + uint(tile.y)) * CLUSTER_GRID.x + uint(tile.x)];
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < cluster.y; i++)
+    {
+        ClusterLight light = uLights[uLightIndices[cluster.x + i]];
+
+        vec3 toLight = light.PositionRadius.xyz - viewPosition;
+        float distance = length(toLight);
+        float falloff = clamp(1.0 - distance / light.PositionRadius.w, 0.0, 1.0);
+        float diffuse = max(dot(viewNormal, toLight / max(distance, 0.0001)), 0.0);
+
+        result += light.ColorIntensity.rgb * light.ColorIntensity.w * diffuse * falloff * falloff;
+    }
+    return result;
+}
@@ -1,23 +1,4 @@
-#version 460 core
-
-in DATA
-{
-    vec3 Position;
-    vec3 Normal;
-    vec3 LocalPosition;
-    vec3 LocalNormal;
-}
-data_in;
-
-out vec4 FragColor;
-
-uniform vec3 uLightPos;
-uniform vec3 uLightColor;
-uniform vec3 uObjectColor;
-uniform vec3 uWireframeColor;
-uniform float uTime;
-uniform float uResolution;
-uniform int uIsWireframe;
+#pragma once
 
 #define PI 3.14159265359
 
@@ -98,15 +79,3 @@ float snoise(vec3 v)
     m = m * m;
     return 42.0 * dot(m * m, vec4(dot(p0, x0), dot(p1, x1), dot(p2, x2), dot(p3, x3)));
 }
-
-void main()
-{
-    if (uIsWireframe == 1)
-    {
-        FragColor = vec4(uWireframeColor, 1.0);
-        return;
-    }
-
-    float n = snoise(data_in.Position * 3.0) * 0.5 + 0.5;
-    FragColor = vec4(n * uObjectColor, n);
-}
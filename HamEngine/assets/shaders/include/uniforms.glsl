@@ -0,0 +1,15 @@
+#pragma once
+
+uniform mat4 uModel;
+uniform mat4 uNormalMatrix; // transpose(inverse(uModel)), computed on the CPU once per draw
+uniform mat4 uView;
+uniform mat4 uProjection;
+uniform float uTime;
+uniform vec2 uResolution;
+uniform int uID;
+uniform int uIsWireframe;
+
+uniform vec3 uAmbientLight;
+uniform vec2 uClusterDepthRange;
+uniform vec3 uObjectColor;
+uniform vec3 uWireframeColor;
@@ -0,0 +1,53 @@
+#pragma once
+
+// Single pass wireframe without a geometry shader. The fragment looks up its triangle through gl_PrimitiveID in
+// the draw's index and vertex buffers (bound as storage buffers 1 and 2), computes its barycentric coordinates from
+// the interpolated local position and turns the distance to the closest edge into line coverage in pixels.
+
+struct WireframeVertex // Component::VertexData, vec3 members are 16 byte aligned on both sides
+{
+    vec3 Position;
+    vec3 Normal;
+};
+
+layout (std430, binding = 1) readonly buffer WireframeVertexBuffer
+{
+    WireframeVertex uWireframeVertices[];
+};
+
+layout (std430, binding = 2) readonly buffer WireframeIndexBuffer
+{
+    uint uWireframeIndices[];
+};
+
+flat in ivec2 vTriangleBase; // first index and base vertex of the draw
+
+vec3 GetTriangleCorner(int corner)
+{
+    uint index = uWireframeIndices[vTriangleBase.x + gl_PrimitiveID * 3 + corner] + uint(vTriangleBase.y);
+    return uWireframeVertices[index].Position;
+}
+
+float GetWireframeCoverage(vec3 localPosition, float width)
+{
+    vec3 a = GetTriangleCorner(0);
+    vec3 ab = GetTriangleCorner(1) - a;
+    vec3 ac = GetTriangleCorner(2) - a;
+    vec3 ap = localPosition - a;
+
+    float d00 = dot(ab, ab);
+    float d01 = dot(ab, ac);
+    float d11 = dot(ac, ac);
+    float d20 = dot(ap, ab);
+    float d21 = dot(ap, ac);
+    float denominator = max(d00 * d11 - d01 * d01, 1e-12); // no early out, fwidth needs uniform control flow
+
+    float v = (d11 * d20 - d01 * d21) / denominator;
+    float w = (d00 * d21 - d01 * d20) / denominator;
+    vec3 barycentric = vec3(1.0 - v - w, v, w);
+
+    // screen space rate of change turns barycentric distance into pixels
+    vec3 pixels = barycentric / max(fwidth(barycentric), vec3(1e-6));
+    float closest = min(min(pixels.x, pixels.y), pixels.z);
+    return 1.0 - clamp(closest - width * 0.5 + 0.5, 0.0, 1.0);
+}
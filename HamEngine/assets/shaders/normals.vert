@@ -0,0 +1,48 @@
+#version 460 core
+
+// Normal debug lines without a geometry shader. Every instance is one vertex of the mesh, read from the vertex
+// buffer bound as storage buffer 1, and draws a two vertex line: gl_VertexID 0 is the base, 1 the tip.
+
+out DATA
+{
+#include "include/data.glsl"
+}
+data_out;
+
+#include "include/uniforms.glsl"
+
+const float NORMAL_LENGTH = 0.1;
+
+struct Vertex // Component::VertexData, vec3 members are 16 byte aligned on both sides
+{
+    vec3 Position;
+    vec3 Normal;
+};
+
+layout (std430, binding = 1) readonly buffer NormalVertexBuffer
+{
+    Vertex uVertices[];
+};
+
+void main()
+{
+    vec3 position = uVertices[gl_InstanceID].Position;
+    vec3 normal = uVertices[gl_InstanceID].Normal;
+
+    data_out.Normal = mat3(uNormalMatrix) * normal;
+    data_out.LocalNormal = normal;
+    data_out.ID = uID;
+
+    if (gl_VertexID == 0)
+    {
+        data_out.LocalPosition = position;
+        data_out.Position = vec3(uModel * vec4(position, 1.0));
+    }
+    else
+    {
+        data_out.LocalPosition = position + normal * NORMAL_LENGTH;
+        data_out.Position = vec3(uModel * vec4(data_out.LocalPosition, 1.0)) + data_out.Normal * NORMAL_LENGTH;
+    }
+
+    gl_Position = uProjection * uView * vec4(data_out.Position, 1.0);
+}
@@ -2,25 +2,19 @@
 
 in DATA
 {
-    vec3 Position;
-    vec3 Normal;
-    vec3 LocalPosition;
-    vec3 LocalNormal;
+#include "include/data.glsl"
 }
 data_in;
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out uint EntityID;
 
-uniform vec3 uLightPos;
-uniform vec3 uLightColor;
-uniform vec3 uObjectColor;
-uniform vec3 uWireframeColor;
-uniform float uTime;
-uniform float uResolution;
-uniform int uIsWireframe;
+#include "include/uniforms.glsl"
 
 void main()
 {
+    EntityID = uint(data_in.ID);
+
     vec3 color = vec3(1.0, 0.5, 0.0);
     FragColor = vec4(color, 1.0);
 }
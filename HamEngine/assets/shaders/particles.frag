@@ -0,0 +1,13 @@
+#version 460 core
+
+in vec2 vCorner;
+in vec4 vColor;
+
+layout (location = 0) out vec4 FragColor;
+
+void main()
+{
+    // soft round sprite, blended additively
+    float falloff = 1.0 - smoothstep(0.0, 1.0, dot(vCorner, vCorner));
+    FragColor = vec4(vColor.rgb, vColor.a * falloff);
+}
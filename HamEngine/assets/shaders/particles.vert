@@ -0,0 +1,50 @@
+#version 460 core
+
+// Camera facing particle quads. Every instance is one particle, drawn as a four vertex triangle strip. All emitters
+// share one multi draw: gl_BaseInstance is where the emitter's particles start and gl_DrawID picks its draw data.
+
+#include "include/uniforms.glsl"
+
+struct Particle // ParticleInstance
+{
+    vec3 Position;
+    float Age; // 0 at birth, 1 when it dies
+};
+
+struct Emitter // ParticleEmitterData
+{
+    vec4 StartColor;
+    vec4 EndColor;
+    vec4 Size;
+};
+
+layout (std430, binding = 6) readonly buffer ParticleBuffer
+{
+    Particle uParticles[];
+};
+
+layout (std430, binding = 7) readonly buffer ParticleEmitterBuffer
+{
+    Emitter uEmitters[];
+};
+
+out vec2 vCorner;
+out vec4 vColor;
+
+void main()
+{
+    Particle particle = uParticles[gl_BaseInstance + gl_InstanceID];
+    Emitter emitter = uEmitters[gl_DrawID];
+
+    float age = clamp(particle.Age, 0.0, 1.0);
+    vColor = mix(emitter.StartColor, emitter.EndColor, age);
+    vCorner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+
+    // the rows of the view matrix are the camera axes in world space
+    vec3 right = vec3(uView[0][0], uView[1][0], uView[2][0]);
+    vec3 up = vec3(uView[0][1], uView[1][1], uView[2][1]);
+    float size = mix(emitter.Size.x, emitter.Size.y, age);
+    vec3 position = particle.Position + (right * vCorner.x + up * vCorner.y) * size;
+
+    gl_Position = uProjection * uView * vec4(position, 1.0);
+}
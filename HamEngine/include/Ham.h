@@ -17,6 +17,7 @@
 #include "Ham/Core/FileSystem.h"
 #include "Ham/Core/Assert.h"
 #include "Ham/Debug/Profiler.h"
+#include "Ham/Debug/DebugDraw.h"
 
 #include "Ham/Core/Application.h"
 #include "Ham/Core/Layer.h"
@@ -39,6 +40,7 @@
 #include "Ham/Scene/Scene.h"
 #include "Ham/Scene/Entity.h"
 #include "Ham/Scene/Component.h"
+#include "Ham/Scene/Heightfield.h"
 #include "Ham/Scene/Systems.h"
 
 // #include "Ham/Script/NativeScript.h"
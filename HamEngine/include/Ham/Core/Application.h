@@ -6,7 +6,15 @@
 #include "Ham/Core/LayerStack.h"
 #include "Ham/ImGui/ImGuiImpl.h"
 #include "Ham/Scene/Scene.h"
+#include "Ham/Renderer/DynamicResolution.h"
 #include "Ham/Renderer/FrameBuffer.h"
+#include "Ham/Renderer/GeometryBuffer.h"
+#include "Ham/Renderer/LightClusters.h"
+#include "Ham/Renderer/OcclusionCuller.h"
+#include "Ham/Renderer/PixelReadback.h"
+#include "Ham/Renderer/RenderGraph.h"
+#include "Ham/Renderer/RenderTargetPool.h"
+#include "Ham/Renderer/RingBuffer.h"
 #include "Ham/Events/EventBase.h"
 
 #include <sol/sol.hpp>
@@ -34,6 +42,11 @@ enum FullscreenMode {
   APPLICATION_FULLSCREEN_BORDERLESS
 };
 
+enum RenderMode {
+  RENDER_MODE_DIRECT,
+  RENDER_MODE_MULTI_DRAW_INDIRECT
+};
+
 struct ApplicationSpecification {
   std::string Name = "Ham Engine Application";
 
@@ -49,6 +62,17 @@ struct ApplicationSpecification {
   bool Maximized = false;
   int Display = 0;
   FullscreenMode Fullscreen = APPLICATION_WINDOWED;
+  RenderMode Rendering = RENDER_MODE_DIRECT;
+
+  // headless: offscreen context without a visible window, for benchmarks and image-diff tests on CI
+  // (command line: --headless, --frames <count>, --capture <file.ppm>)
+  bool Headless = false;
+  uint32_t FrameLimit = 0;  // exit after this many frames, 0 runs until closed
+  std::string CapturePath;  // the last frame's color is saved here
+
+  // render the scene below window resolution when frames take longer than 1 / TargetFrameRate (--dynamic-resolution)
+  bool DynamicResolution = false;
+  float TargetFrameRate = 60.0f;
 
   ApplicationCommandLineArgs CommandLineArgs;
 };
@@ -77,6 +101,7 @@ class Application {
   bool IsEditorEnabled() { return m_EditorEnabled; }
 
   void TriggerCameraUpdate() { m_FramebufferResized = true; }
+  bool IsHeadless() const { return m_Specification.Headless; }
 
   Window &GetWindow() { return m_Window; }
   GLFWwindow *GetWindowHandle() { return m_Window.GetWindowHandle(); }
@@ -84,14 +109,29 @@ class Application {
   ImGuiImpl &GetImGui() { return m_imgui; }
   float GetTime() { return m_Window.GetTime(); }
   const ApplicationSpecification &GetSpecification() const { return m_Specification; }
-  FrameBuffer &GetObjectPickerFramebuffer() { return m_ObjectPickerFramebuffer; }
+  FrameBuffer &GetSceneFramebuffer() { return m_SceneFramebuffer; }
+  GeometryBuffer &GetGeometryBuffer() { return m_GeometryBuffer; }
+  IndirectBuffer &GetIndirectCommandBuffer() { return m_IndirectCommandBuffer; }
+  StorageBuffer<IndirectDrawData> &GetIndirectDrawDataBuffer() { return m_IndirectDrawDataBuffer; }
+  RingBuffer &GetStreamBuffer() { return m_StreamBuffer; }
+  OcclusionCuller &GetOcclusionCuller() { return m_OcclusionCuller; }
+  LightClusters &GetLightClusters() { return m_LightClusters; }
+  StorageBuffer<ClusterLight> &GetLightBuffer() { return m_LightBuffer; }
+  StorageBuffer<LightCluster> &GetLightClusterBuffer() { return m_LightClusterBuffer; }
+  StorageBuffer<uint32_t> &GetLightIndexBuffer() { return m_LightIndexBuffer; }
+  StorageBuffer<uint8_t> &GetParticleBuffer() { return m_ParticleBuffer; }
+  RenderTargetPool &GetRenderTargetPool() { return m_RenderTargetPool; }
+  DynamicResolution &GetDynamicResolution() { return m_DynamicResolution; }
+  const RenderGraph &GetRenderGraph() const { return m_RenderGraph; }
 
   void SetWindowed() { m_Window.SetWindowed(); }
   void SetFullscreen() { m_Window.SetFullscreen(); }
   void SetFullscreenBorderless() { m_Window.SetFullscreenBorderless(); }
   void SetVSync(bool enabled) { m_Window.SetVSync(enabled); }
+  void SetRenderMode(RenderMode mode) { m_Specification.Rendering = mode; }
 
   bool IsVSync() const { return m_Window.IsVSync(); }
+  RenderMode GetRenderMode() const { return m_Specification.Rendering; }
 
   sol::state &GetLua() { return m_LuaState; }
 
@@ -115,6 +155,9 @@ class Application {
 
  private:
   ApplicationSpecification &GetSpecificationMutable() { return m_Specification; }
+  void ParseCommandLine();
+  void FinishHeadlessRun(uint64_t frameCount, float seconds);
+  void OnMeshDestroyed(entt::registry &registry, entt::entity entity);
 
  protected:
   Window m_Window;
@@ -139,7 +182,22 @@ class Application {
 
   friend ::Ham::Window;
 
-  FrameBuffer m_ObjectPickerFramebuffer;
+  FrameBuffer m_SceneFramebuffer;  // attachment 0: color, attachment 1: entity ids (R32UI)
+  PixelReadback m_ObjectPickerReadback;
+
+  GeometryBuffer m_GeometryBuffer;
+  IndirectBuffer m_IndirectCommandBuffer;
+  StorageBuffer<IndirectDrawData> m_IndirectDrawDataBuffer;
+  RingBuffer m_StreamBuffer;  // per-frame data written by the render thread, see RingBuffer
+  OcclusionCuller m_OcclusionCuller;
+  LightClusters m_LightClusters;
+  StorageBuffer<ClusterLight> m_LightBuffer;  // uploaded from m_LightClusters every frame, see include/lights.glsl
+  StorageBuffer<LightCluster> m_LightClusterBuffer;
+  StorageBuffer<uint32_t> m_LightIndexBuffer;
+  StorageBuffer<uint8_t> m_ParticleBuffer;  // only used on frames the particles don't fit in m_StreamBuffer
+  RenderTargetPool m_RenderTargetPool;  // borrowed by passes on the render thread, returned at the end of each frame
+  RenderGraph m_RenderGraph;            // rebuilt every frame by the render thread
+  DynamicResolution m_DynamicResolution;  // scale of m_SceneFramebuffer relative to the window
 
   sol::state m_LuaState;
 
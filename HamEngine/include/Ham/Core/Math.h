@@ -150,6 +150,18 @@ auto dot(const V &a, const V &b)
   return mathter::Dot(a, b);
 }
 
+template <typename V>
+auto min(const V &a, const V &b)
+{
+  return mathter::Min(a, b);
+}
+
+template <typename V>
+auto max(const V &a, const V &b)
+{
+  return mathter::Max(a, b);
+}
+
 template <typename... Args>
 inline auto cross(Args &&...args) -> decltype(mathter::Cross(std::forward<Args>(args)...))
 {
@@ -56,6 +56,7 @@ class Window {
   void SetVSync(bool enabled);
 
   GLFWwindow *GetWindowHandle() const { return m_Window; }
+  GLFWwindow *GetLoaderContext() const { return m_LoaderContext; }
   std::string GetGLSLVersion() const { return m_glsl_version; }
   math::vec2 GetSize() const;
   int GetWidth() const;
@@ -72,6 +73,7 @@ class Window {
   }
   math::vec4 &GetClearColor() { return m_ClearColor; }
   bool IsVSync() const;
+  bool IsHeadless() const;
   const std::string &GetTitle() const;
   const ApplicationSpecification &GetSpecification() const;
 
@@ -85,10 +87,14 @@ class Window {
   static void ReadLineCallback(ImGuiContext *, ImGuiSettingsHandler *, void *entry, const char *line);
   static void WriteAllCallback(ImGuiContext *, ImGuiSettingsHandler *handler, ImGuiTextBuffer *buf);
 
+  void InitHeadlessPlatform();
+  GLFWwindow *CreateHeadlessWindow();
+
  private:
   std::atomic_bool m_IsRunning = false;
 
   GLFWwindow *m_Window;
+  GLFWwindow *m_LoaderContext = nullptr;
   Application *m_Application;
 
   math::vec4 m_ClearColor;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+#include "Ham/Renderer/Buffer.h"
+#include "Ham/Renderer/PipelineState.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Ham {
+class RingBuffer;
+
+struct DebugVertex {
+  math::vec3 Position;
+  uint32_t Color;  // RGBA8, see DebugDraw::PackColor
+};
+
+// Immediate mode debug lines. Anything can be called from any thread during the frame: every thread appends to its
+// own vertex lists, Render merges them and draws everything with at most two glDrawArrays calls (depth tested and
+// overlay) straight out of the stream ring buffer. Shapes submitted after the scene pass show up in the next frame.
+class DebugDraw {
+ public:
+  static void Line(const math::vec3 &from, const math::vec3 &to, const math::vec4 &color, bool overlay = false);
+  static void Box(const math::vec3 &min, const math::vec3 &max, const math::vec4 &color, bool overlay = false);
+  static void Box(const math::vec3 &min, const math::vec3 &max, const math::mat4 &transform, const math::vec4 &color, bool overlay = false);
+  static void Circle(const math::vec3 &center, const math::vec3 &normal, float radius, const math::vec4 &color, bool overlay = false, uint32_t segments = 32);
+  static void Sphere(const math::vec3 &center, float radius, const math::vec4 &color, bool overlay = false, uint32_t segments = 32);
+  // the frustum whose clip space is described by projection * view
+  static void Frustum(const math::mat4 &viewProjection, const math::vec4 &color, bool overlay = false);
+  static void Axes(const math::mat4 &transform, float size = 1.0f, bool overlay = false);
+
+  // Render thread only, inside a pass with the scene framebuffer bound
+  static void Render(RingBuffer &stream, const math::mat4 &viewProjection);
+  static void Clear();
+
+  static uint32_t GetLastLineCount() { return s_LastLineCount; }
+
+  static uint32_t PackColor(const math::vec4 &color);
+
+ private:
+  enum Layer : uint32_t {
+    DEPTH_TESTED,
+    OVERLAY,
+    LAYER_COUNT,
+  };
+
+  struct ThreadLines {
+    std::mutex Mutex;  // only contended while Render merges
+    std::vector<DebugVertex> Vertices[LAYER_COUNT];
+  };
+
+  static ThreadLines &GetThreadLines();
+  static void AddCorners(const math::vec3 (&corners)[8], uint32_t color, bool overlay);
+
+ private:
+  static std::mutex s_Mutex;
+  static std::vector<std::unique_ptr<ThreadLines>> s_Threads;
+  static std::vector<DebugVertex> s_Merged;
+  static std::shared_ptr<VertexArray> s_VertexArray;
+  static VertexBuffer<DebugVertex> s_FallbackBuffer;  // used on frames the stream ring overflows
+  static uint32_t s_LastLineCount;
+  static uint32_t s_PipelineShader;            // handle of the shader s_Pipelines were made for
+  static PipelineID s_Pipelines[LAYER_COUNT];  // blended, no depth or entity id writes
+};
+
+}  // namespace Ham
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Ham/Debug/Profiler.h"
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if HAM_ENABLE_PROFILING == HAM_USE_PROFILER_TRACY
+#include <tracy/TracyOpenGL.hpp>
+#endif
+
+namespace Ham {
+
+struct GpuZoneResult {
+  std::string Name;
+  uint32_t Depth;
+  float Milliseconds;
+  float Average;  // smoothed over the last frames, steadier to read in the editor
+};
+
+// GPU time per zone from GL_TIMESTAMP queries. Every zone writes a timestamp at its begin and end (unlike
+// GL_TIME_ELAPSED these can nest), and each frame has its own set of queries in a ring of FrameCount. A frame is
+// only read back when it comes around again, by then the GPU is done with it, so the CPU never waits; a frame
+// whose queries are still pending is dropped instead. Render thread only.
+class GpuProfiler {
+ public:
+  static constexpr uint32_t FrameCount = 4;
+  static constexpr uint32_t MaxZones = 64;  // per frame, more are ignored
+
+  static void Init();
+  static void Shutdown();
+
+  // BeginFrame resolves the oldest frame in the ring and opens a "Frame" zone that EndFrame closes
+  static void BeginFrame();
+  static void EndFrame();
+
+  static void BeginZone(const std::string &name);
+  static void EndZone();
+
+  static bool IsEnabled() { return s_Enabled; }
+  static const std::vector<GpuZoneResult> &GetResults() { return s_Results; }  // last resolved frame, in begin order
+  static uint32_t GetDroppedFrameCount() { return s_DroppedFrames; }
+  static float GetFrameTime() { return s_Results.empty() ? 0.0f : s_Results[0].Milliseconds; }  // "Frame" zone, 0 if unknown
+
+ private:
+  struct Zone {
+    std::string Name;
+    uint32_t Depth;
+    uint32_t BeginQuery;
+    uint32_t EndQuery;
+  };
+
+  struct Frame {
+    GLuint Queries[MaxZones * 2];
+    std::vector<Zone> Zones;
+    std::vector<uint32_t> Open;  // indices of zones not ended yet
+    uint32_t QueryCount = 0;
+    bool Pending = false;
+  };
+
+  static void Resolve(Frame &frame);
+
+  static bool s_Enabled;
+  static Frame s_Frames[FrameCount];
+  static uint32_t s_FrameIndex;
+  static uint32_t s_DroppedFrames;
+  static std::vector<GpuZoneResult> s_Results;
+  static std::unordered_map<std::string, float> s_Averages;
+};
+
+class GpuProfilerScope {
+ public:
+  GpuProfilerScope(const std::string &name) { GpuProfiler::BeginZone(name); }
+  ~GpuProfilerScope() { GpuProfiler::EndZone(); }
+};
+
+}  // namespace Ham
+
+#define HAM_PROFILE_GPU_CONCAT_IMPL(a, b) a##b
+#define HAM_PROFILE_GPU_CONCAT(a, b)      HAM_PROFILE_GPU_CONCAT_IMPL(a, b)
+
+#if HAM_ENABLE_PROFILING == HAM_USE_PROFILER_TRACY
+#define HAM_PROFILE_GPU_CONTEXT()  TracyGpuContext
+#define HAM_PROFILE_GPU_COLLECT()  TracyGpuCollect
+// name can be any const char *, Tracy copies it
+#define HAM_PROFILE_GPU_SCOPE(name)                                                 \
+  TracyGpuZoneTransient(HAM_PROFILE_GPU_CONCAT(tracyGpuZone, __LINE__), name, true); \
+  ::Ham::GpuProfilerScope HAM_PROFILE_GPU_CONCAT(gpuProfilerScope, __LINE__)(name)
+#else
+#define HAM_PROFILE_GPU_CONTEXT()
+#define HAM_PROFILE_GPU_COLLECT()
+#define HAM_PROFILE_GPU_SCOPE(name) ::Ham::GpuProfilerScope HAM_PROFILE_GPU_CONCAT(gpuProfilerScope, __LINE__)(name)
+#endif
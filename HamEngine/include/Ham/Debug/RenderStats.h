@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+
+enum class RenderCounter : uint32_t {
+  DRAW_CALLS,
+  TRIANGLES,
+  PROGRAM_BINDS,
+  UNIFORM_UPDATES,
+  VERTEX_ARRAY_BINDS,
+  STATE_CHANGES,
+  FRAMEBUFFER_BINDS,
+  CLEARS,
+  BUFFER_UPLOADS,
+  UPLOAD_BYTES,
+
+  COUNT
+};
+
+struct RenderStatsFrame {
+  std::array<uint64_t, (size_t)RenderCounter::COUNT> Values = {};
+
+  uint64_t operator[](RenderCounter counter) const { return Values[(size_t)counter]; }
+};
+
+// Per-frame counters of the GL work the engine issues. Code that talks to GL calls Add (a relaxed atomic
+// increment, so the few calls made off the render thread are fine); EndFrame moves the counts into the last
+// frame snapshot and a rolling history, so readers always see a complete frame and never the one being counted.
+// Draws made by ImGui's backend are not included.
+class RenderStats {
+ public:
+  static constexpr uint32_t HistorySize = 240;
+
+  static void Add(RenderCounter counter, uint64_t value = 1) { s_Current[(size_t)counter].fetch_add(value, std::memory_order_relaxed); }
+
+  static void EndFrame();
+
+  static const RenderStatsFrame &GetLastFrame() { return s_LastFrame; }
+  static uint64_t Get(RenderCounter counter) { return s_LastFrame[counter]; }
+
+  // over the frames in the history
+  static RenderStatsFrame GetAverage();
+  static RenderStatsFrame GetMax();
+
+  // oldest first, for plotting
+  static void GetHistory(RenderCounter counter, std::vector<float> &values);
+  static uint32_t GetHistoryCount() { return s_HistoryCount; }
+  static uint64_t GetFrameCount() { return s_FrameCount; }
+
+  static const char *GetName(RenderCounter counter);
+
+ private:
+  static std::array<std::atomic_uint64_t, (size_t)RenderCounter::COUNT> s_Current;
+  static RenderStatsFrame s_LastFrame;
+  static std::array<RenderStatsFrame, HistorySize> s_History;
+  static uint32_t s_HistoryIndex;  // next slot to write
+  static uint32_t s_HistoryCount;
+  static uint64_t s_FrameCount;
+};
+
+}  // namespace Ham
@@ -20,7 +20,7 @@ class EditorLayer : public Layer {
   Application *m_App;
   Scene &m_Scene;
   std::unique_ptr<Shader> shader;
-  FrameBuffer &m_ObjectPickerFramebuffer;
+  FrameBuffer &m_SceneFramebuffer;
   Entity m_EditorCamera;
 };
 
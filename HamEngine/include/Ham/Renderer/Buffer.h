@@ -1,8 +1,15 @@
 #pragma once
 
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/RenderStats.h"
+
 #include <glad/gl.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace Ham {
@@ -13,84 +20,174 @@ enum DrawMode {
   STREAM = GL_STREAM_DRAW
 };
 
+// Layout expected by glMultiDrawElementsIndirect, do not reorder
+struct DrawElementsIndirectCommand {
+  uint32_t Count;
+  uint32_t InstanceCount;
+  uint32_t FirstIndex;
+  int32_t BaseVertex;
+  uint32_t BaseInstance;
+};
+
+// Layout expected by glMultiDrawArraysIndirect, do not reorder
+struct DrawArraysIndirectCommand {
+  uint32_t Count;
+  uint32_t InstanceCount;
+  uint32_t First;
+  uint32_t BaseInstance;
+};
+
+// Element range of a buffer, [First, First + Count)
+struct BufferRange {
+  size_t First;
+  size_t Count;
+};
+
+// Owns its GL buffer alone. A STATIC buffer gets a new ID when its size changes, so a copy sharing the ID would keep
+// drawing from a deleted buffer. Copies are not allowed, moving hands the buffer over.
 template <typename T, uint32_t BufferType>
 class Buffer {
  public:
   Buffer() {}
   ~Buffer() {}
 
+  Buffer(const Buffer &) = delete;
+  Buffer &operator=(const Buffer &) = delete;
+  Buffer(Buffer &&other) noexcept { *this = std::move(other); }
+  Buffer &operator=(Buffer &&other) noexcept
+  {
+    m_BufferID = std::exchange(other.m_BufferID, 0);
+    m_DrawMode = other.m_DrawMode;
+    m_Capacity = std::exchange(other.m_Capacity, 0);
+    m_Data = std::move(other.m_Data);
+    m_DirtyRanges = std::move(other.m_DirtyRanges);
+    m_FlushedRanges = std::move(other.m_FlushedRanges);
+    m_isInitialized = std::exchange(other.m_isInitialized, false);
+    return *this;
+  }
+
   void Create()
   {
-    glGenBuffers(1, &m_BufferID);
+    glCreateBuffers(1, &m_BufferID);
     m_isInitialized = true;
   }
 
   void Destroy()
   {
     glDeleteBuffers(1, &m_BufferID);
+    m_BufferID = 0;
+    m_Capacity = 0;
     m_isInitialized = false;
   }
 
-  void Bind()
-  {
-    glBindBuffer(BufferType, m_BufferID);
-  }
+  // only needed to use the buffer, uploads don't depend on what is bound
+  void Bind() { glBindBuffer(BufferType, m_BufferID); }
   void Unbind() { glBindBuffer(BufferType, 0); }
+  void BindBase(uint32_t index) { glBindBufferBase(BufferType, index, m_BufferID); }
+  uint32_t GetID() const { return m_BufferID; }
 
-  void SetData(std::vector<T> data)
+  void SetData(const std::vector<T> &data)
   {
     m_Data = data;
-    Bind();
-    glBufferData(BufferType, (int)m_Data.size() * sizeof(T), m_Data.data(), m_DrawMode);
+    m_DirtyRanges.clear();
+
+    size_t size = m_Data.size() * sizeof(T);
+    RenderStats::Add(RenderCounter::BUFFER_UPLOADS);
+    RenderStats::Add(RenderCounter::UPLOAD_BYTES, size);
+
+    if (m_DrawMode == DrawMode::STATIC) {
+      // immutable storage sized to the data, a different size needs a new buffer object (and ID)
+      if (size != m_Capacity || m_Capacity == 0) {
+        if (m_Capacity != 0) {
+          glDeleteBuffers(1, &m_BufferID);
+          glCreateBuffers(1, &m_BufferID);
+        }
+        m_Capacity = std::max(size, sizeof(T));  // zero sized storage is an error
+        glNamedBufferStorage(m_BufferID, m_Capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+      }
+      glNamedBufferSubData(m_BufferID, 0, size, m_Data.data());
+      return;
+    }
+
+    // DYNAMIC/STREAM buffers keep their storage and only reallocate (with headroom) when the data outgrows it
+    if (size > m_Capacity) {
+      m_Capacity = std::max(size, m_Capacity * 2);
+      glNamedBufferData(m_BufferID, m_Capacity, nullptr, m_DrawMode);
+    }
+    glNamedBufferSubData(m_BufferID, 0, size, m_Data.data());
   }
 
-  bool IsInitialized() { return m_isInitialized; }
+  bool IsInitialized() const { return m_isInitialized; }
 
-  size_t Size() { return m_Data.size(); }
+  size_t Size() const { return m_Data.size(); }
 
   std::vector<T> &GetData() { return m_Data; }
+  const std::vector<T> &GetData() const { return m_Data; }
 
-  template <typename U>
-  void DefineAttribute(size_t offset, uint32_t length, uint32_t type, bool normalized = false)
+  // Writable view of part of the CPU copy, the range is uploaded by the next Flush()
+  std::span<T> Modify(size_t first, size_t count)
   {
-    glEnableVertexAttribArray(m_AttributeIndex);
-    glVertexAttribPointer(m_AttributeIndex, length, type, normalized ? GL_TRUE : GL_FALSE, sizeof(T), (void *)offset);
-    m_AttributeIndex++;
+    MarkDirty(first, count);
+    return std::span<T>(m_Data.data() + first, count);
   }
 
-  void SetDrawMode(uint32_t mode) { m_DrawMode = mode; }
+  // For edits made through GetData()
+  void MarkDirty(size_t first, size_t count)
+  {
+    HAM_CORE_ASSERT(first + count <= m_Data.size(), "Dirty range outside of the buffer!");
+    if (count > 0)
+      m_DirtyRanges.push_back({first, count});
+  }
 
-  void DefineAttribute1f(size_t offset, bool normalized = false) { DefineAttribute<float>(offset, 1, GL_FLOAT, normalized); }
-  void DefineAttribute2f(size_t offset, bool normalized = false) { DefineAttribute<math::vec2>(offset, 2, GL_FLOAT, normalized); }
-  void DefineAttribute3f(size_t offset, bool normalized = false) { DefineAttribute<math::vec3>(offset, 3, GL_FLOAT, normalized); }
-  void DefineAttribute4f(size_t offset, bool normalized = false) { DefineAttribute<math::vec4>(offset, 4, GL_FLOAT, normalized); }
+  bool IsDirty() const { return !m_DirtyRanges.empty(); }
 
-  void DefineAttribute1i(size_t offset, bool normalized = false) { DefineAttribute<int>(offset, 1, GL_INT, normalized); }
-  void DefineAttribute2i(size_t offset, bool normalized = false) { DefineAttribute<math::ivec2>(offset, 2, GL_INT, normalized); }
-  void DefineAttribute3i(size_t offset, bool normalized = false) { DefineAttribute<math::ivec3>(offset, 3, GL_INT, normalized); }
-  void DefineAttribute4i(size_t offset, bool normalized = false) { DefineAttribute<math::ivec4>(offset, 4, GL_INT, normalized); }
+  // Uploads the dirty ranges, merged where they overlap or are less than MergeGap bytes apart (one bigger upload is
+  // cheaper than many small ones). Returns the ranges that were uploaded, valid until the next Flush().
+  const std::vector<BufferRange> &Flush()
+  {
+    HAM_CORE_ASSERT(m_isInitialized, "Buffer not created!");
+    m_FlushedRanges.clear();
+    if (m_DirtyRanges.empty())
+      return m_FlushedRanges;
 
-  void DefineAttribute1ui(size_t offset, bool normalized = false) { DefineAttribute<uint32_t>(offset, 1, GL_UNSIGNED_INT, normalized); }
-  void DefineAttribute2ui(size_t offset, bool normalized = false) { DefineAttribute<math::uvec2>(offset, 2, GL_UNSIGNED_INT, normalized); }
-  void DefineAttribute3ui(size_t offset, bool normalized = false) { DefineAttribute<math::uvec3>(offset, 3, GL_UNSIGNED_INT, normalized); }
-  void DefineAttribute4ui(size_t offset, bool normalized = false) { DefineAttribute<math::uvec4>(offset, 4, GL_UNSIGNED_INT, normalized); }
+    std::sort(m_DirtyRanges.begin(), m_DirtyRanges.end(), [](const BufferRange &a, const BufferRange &b) { return a.First < b.First; });
 
-  void DefineAttributeMat2(size_t offset, bool normalized = false) { DefineAttribute<math::mat2>(offset, 2 * 2, GL_FLOAT, normalized); }
-  void DefineAttributeMat3(size_t offset, bool normalized = false) { DefineAttribute<math::mat3>(offset, 3 * 3, GL_FLOAT, normalized); }
-  void DefineAttributeMat4(size_t offset, bool normalized = false) { DefineAttribute<math::mat4>(offset, 4 * 4, GL_FLOAT, normalized); }
+    size_t gap = MergeGap / sizeof(T);
+    BufferRange current = m_DirtyRanges[0];
+    for (size_t i = 1; i < m_DirtyRanges.size(); i++) {
+      auto &range = m_DirtyRanges[i];
+      if (range.First <= current.First + current.Count + gap) {
+        current.Count = std::max(current.Count, range.First + range.Count - current.First);
+        continue;
+      }
+      m_FlushedRanges.push_back(current);
+      current = range;
+    }
+    m_FlushedRanges.push_back(current);
+    m_DirtyRanges.clear();
 
-  void DefineAttribute1b(size_t offset, bool normalized = false) { DefineAttribute<bool>(offset, 1, GL_BOOL, normalized); }
-  void DefineAttribute2b(size_t offset, bool normalized = false) { DefineAttribute<math::bvec2>(offset, 2, GL_BOOL, normalized); }
-  void DefineAttribute3b(size_t offset, bool normalized = false) { DefineAttribute<math::bvec3>(offset, 3, GL_BOOL, normalized); }
-  void DefineAttribute4b(size_t offset, bool normalized = false) { DefineAttribute<math::bvec4>(offset, 4, GL_BOOL, normalized); }
+    for (auto &range : m_FlushedRanges) {
+      glNamedBufferSubData(m_BufferID, range.First * sizeof(T), range.Count * sizeof(T), m_Data.data() + range.First);
+      RenderStats::Add(RenderCounter::BUFFER_UPLOADS);
+      RenderStats::Add(RenderCounter::UPLOAD_BYTES, range.Count * sizeof(T));
+    }
+
+    return m_FlushedRanges;
+  }
+
+  // STATIC (the default) uses immutable storage, DYNAMIC/STREAM a mutable store that grows
+  void SetDrawMode(DrawMode mode) { m_DrawMode = mode; }
 
  private:
-  uint32_t m_BufferID;
+  uint32_t m_BufferID = 0;
   DrawMode m_DrawMode = DrawMode::STATIC;
+  size_t m_Capacity = 0;
 
   std::vector<T> m_Data;
 
-  uint32_t m_AttributeIndex = 0;
+  static constexpr size_t MergeGap = 256;
+  std::vector<BufferRange> m_DirtyRanges;
+  std::vector<BufferRange> m_FlushedRanges;
 
   bool m_isInitialized = false;
 };
@@ -98,32 +195,76 @@ class Buffer {
 template <typename T>
 using VertexBuffer = Buffer<T, GL_ARRAY_BUFFER>;
 using IndexBuffer = Buffer<uint32_t, GL_ELEMENT_ARRAY_BUFFER>;
+template <typename T>
+using StorageBuffer = Buffer<T, GL_SHADER_STORAGE_BUFFER>;
+using IndirectBuffer = Buffer<DrawElementsIndirectCommand, GL_DRAW_INDIRECT_BUFFER>;
+
+struct VertexAttribute {
+  uint32_t Offset;
+  uint32_t Components;
+  uint32_t Type;
+  bool Normalized;
 
+  bool operator==(const VertexAttribute &other) const = default;
+};
+
+// Attributes of one interleaved vertex buffer, in location order
+class VertexLayout {
+ public:
+  VertexLayout(uint32_t stride = 0) : m_Stride(stride) {}
+
+  VertexLayout &Add(size_t offset, uint32_t components, uint32_t type = GL_FLOAT, bool normalized = false)
+  {
+    m_Attributes.push_back({(uint32_t)offset, components, type, normalized});
+    return *this;
+  }
+
+  uint32_t GetStride() const { return m_Stride; }
+  const std::vector<VertexAttribute> &GetAttributes() const { return m_Attributes; }
+
+  bool operator==(const VertexLayout &other) const = default;
+
+ private:
+  uint32_t m_Stride;
+  std::vector<VertexAttribute> m_Attributes;
+};
+
+// The VAO only describes the layout, vertex and index buffers are attached per draw with SetBuffers. That makes one
+// VAO per layout enough, Get() hands out a shared one.
 class VertexArray {
  public:
   VertexArray() {}
   ~VertexArray() { Destroy(); }
 
-  void Create()
-  {
-    glGenVertexArrays(1, &m_VertexArrayID);
-    m_isInitialized = true;
-  }
-  void Destroy()
+  VertexArray(const VertexArray &) = delete;
+  VertexArray &operator=(const VertexArray &) = delete;
+
+  void Create(const VertexLayout &layout);
+  void Destroy();
+
+  void Bind() const
   {
-    glDeleteVertexArrays(1, &m_VertexArrayID);
-    m_isInitialized = false;
+    RenderStats::Add(RenderCounter::VERTEX_ARRAY_BINDS);
+    glBindVertexArray(m_VertexArrayID);
   }
+  void Unbind() const { glBindVertexArray(0); }
 
-  void Bind() { glBindVertexArray(m_VertexArrayID); }
-  void Unbind() { glBindVertexArray(0); }
+  // vertexOffset is in bytes, for vertices that start somewhere inside a shared buffer
+  void SetBuffers(uint32_t vertexBuffer, uint32_t indexBuffer, size_t vertexOffset = 0) const;
 
-  bool IsInitialized() { return m_isInitialized; }
+  bool IsInitialized() const { return m_VertexArrayID != 0; }
+  uint32_t GetID() const { return m_VertexArrayID; }
+  const VertexLayout &GetLayout() const { return m_Layout; }
+
+  // Render thread only, ClearShared() has to run while the context is still current
+  static std::shared_ptr<VertexArray> Get(const VertexLayout &layout);
+  static void ClearShared();
 
  private:
-  uint32_t m_VertexArrayID;
+  uint32_t m_VertexArrayID = 0;
+  VertexLayout m_Layout;
 
-  bool m_isInitialized = false;
+  static std::vector<std::shared_ptr<VertexArray>> s_Shared;
 };
 
 }  // namespace Ham
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+
+// Orders items (transparent draws) back to front. Items are plain indices with a world space center, view depths
+// are computed four at a time and turned into 32 bit keys that are radix sorted, so nothing heavier than a pair of
+// uint32_t is ever moved. Items at the same depth keep the order they were added in. Plain CPU code, no GL context
+// is needed.
+class DepthSorter {
+ public:
+  DepthSorter() {}
+  ~DepthSorter() {}
+
+  void Clear();
+  void Add(const math::vec3 &center, uint32_t item);
+
+  // Farthest from the camera first, valid until the next Clear or Add
+  const std::vector<uint32_t> &Sort(const math::mat4 &view);
+
+  uint32_t GetCount() const { return (uint32_t)m_Items.size(); }
+
+  // Stable LSD radix sort of keys with values carried along, 8 bits per pass. Passes where every key has the same
+  // digit are skipped. The scratch arrays must hold count elements, the result ends up in keys and values.
+  static void RadixSort(uint32_t *keys, uint32_t *values, uint32_t *keysScratch, uint32_t *valuesScratch, uint32_t count);
+
+  // Maps a float to a uint32_t with the same ordering, negative values included
+  static uint32_t ToSortableKey(float value);
+
+ private:
+  void ComputeKeys(const math::mat4 &view);
+
+ private:
+  std::vector<float> m_X, m_Y, m_Z;
+  std::vector<uint32_t> m_Items;
+  std::vector<uint32_t> m_Keys;
+  std::vector<uint32_t> m_KeysScratch, m_ItemsScratch;
+  std::vector<uint32_t> m_Sorted;
+};
+
+}  // namespace Ham
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+
+#include <cstdint>
+
+namespace Ham {
+
+// Picks the render scale of the scene from measured frame times. The scale drops as soon as a frame goes over the
+// target and only creeps back up after a run of frames with headroom, in ScaleStep increments so the target doesn't
+// change size every frame. Only GPU-bound frames lower the scale, a smaller target doesn't make CPU work cheaper.
+class DynamicResolution {
+ public:
+  static constexpr float ScaleStep = 0.05f;
+  static constexpr uint32_t IncreaseDelay = 30;  // frames of headroom before scaling up
+  static constexpr uint32_t Cooldown = 4;        // frames after a change, GPU timings of the old scale are still arriving
+
+  void SetEnabled(bool enabled);
+  bool IsEnabled() const { return m_Enabled; }
+
+  void SetTargetFrameTime(float milliseconds) { m_TargetFrameTime = milliseconds; }
+  float GetTargetFrameTime() const { return m_TargetFrameTime; }
+  void SetScaleRange(float minScale, float maxScale);
+  float GetMinScale() const { return m_MinScale; }
+  float GetMaxScale() const { return m_MaxScale; }
+
+  // Once per frame with the CPU time of the frame (without waiting for vsync) and the latest GPU frame time,
+  // 0 if unknown. Returns true if the scale changed.
+  bool Update(float cpuMilliseconds, float gpuMilliseconds);
+
+  float GetScale() const { return m_Enabled ? m_Scale : 1.0f; }
+  math::uvec2 GetRenderSize(uint32_t width, uint32_t height) const;
+
+  float GetCpuTime() const { return m_CpuTime; }  // smoothed
+  float GetGpuTime() const { return m_GpuTime; }
+
+ private:
+  bool m_Enabled = false;
+  float m_TargetFrameTime = 1000.0f / 60.0f;
+  float m_MinScale = 0.5f;
+  float m_MaxScale = 1.0f;
+  float m_Scale = 1.0f;
+
+  float m_CpuTime = 0.0f;
+  float m_GpuTime = 0.0f;
+  uint32_t m_HeadroomFrames = 0;
+  uint32_t m_CooldownFrames = 0;
+};
+
+}  // namespace Ham
@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <map>
+#include <string>
 #include <vector>
 
 namespace Ham {
@@ -29,6 +30,9 @@ enum class TextureFormat {
   COLOR_RGBUI = GL_RGB8UI,
   COLOR_RGBAUI = GL_RGBA8UI,
 
+  COLOR_R32I = GL_R32I,
+  COLOR_R32UI = GL_R32UI,
+
   COLOR_R8 = GL_R8,
   COLOR_RG8 = GL_RG8,
   COLOR_RGB8 = GL_RGB8,
@@ -58,6 +62,7 @@ enum TextureFilter {
 struct FrameBufferSpecification {
   uint32_t Width, Height;
   math::vec4 ClearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+  uint32_t ClearInteger = 0;  // used instead of ClearColor for integer attachments
 
   std::vector<TextureFormat> ColorAttachments = {TextureFormat::COLOR_RGBA8};
   TextureFormat DepthAttachment = TextureFormat::DEPTH24_STENCIL8;
@@ -70,6 +75,9 @@ struct FrameBufferSpecification {
 
 class FrameBuffer {
  public:
+  // Resize allocates in steps of this many pixels so small size changes reuse the textures
+  static constexpr uint32_t SizeClass = 128;
+
   FrameBuffer();
   FrameBuffer(const FrameBufferSpecification &spec);
   ~FrameBuffer();
@@ -79,9 +87,14 @@ class FrameBuffer {
   void Bind() const;
   void Unbind() const;
 
+  // Only reallocates when the new size doesn't fit the allocation or would use less than half of it in either
+  // direction. Otherwise just the rendered area (Width/Height, used by Bind, Blit and ReadPixels) changes.
   void Resize(uint32_t width, uint32_t height);
+  bool Fits(uint32_t width, uint32_t height) const;
 
   void Clear(uint32_t attachmentType) const;
+  // Tells the driver the contents of these attachments (AttachmentType bits) are no longer needed
+  void Discard(uint32_t attachmentType) const;
 
   void SetClearColor(const math::vec4 &color);
   const math::vec4 &GetClearColor() const;
@@ -92,16 +105,30 @@ class FrameBuffer {
   const TextureFormat &GetColorAttachment(uint32_t index) const;
   const TextureFormat &GetDepthAttachment() const;
 
+  uint32_t GetRendererID() const { return m_RendererID; }
   uint32_t GetColorAttachmentID(uint32_t index) const;
   uint32_t GetDepthAttachmentID() const;
 
   uint32_t GetWidth() const;
   uint32_t GetHeight() const;
+  uint32_t GetAllocatedWidth() const { return m_AllocatedWidth; }
+  uint32_t GetAllocatedHeight() const { return m_AllocatedHeight; }
+  // Scale for texture coordinates when sampling an attachment, the rendered area may not fill the texture
+  math::vec2 GetUVScale() const;
+
+  // Copies a color attachment into another framebuffer (0 = default), scaled if a target size is given
+  void Blit(uint32_t attachment, uint32_t target = 0, uint32_t targetWidth = 0, uint32_t targetHeight = 0) const;
+
+  static bool IsIntegerFormat(TextureFormat format);
 
   void Invalidate();
 
-  std::vector<unsigned char> ReadPixels() const;
-  std::vector<unsigned char> ReadPixels(int x, int y, int width, int height) const;
+  // RGBA8 of a color attachment, which must not be an integer one
+  std::vector<unsigned char> ReadPixels(uint32_t attachment = 0) const;
+  std::vector<unsigned char> ReadPixels(int x, int y, int width, int height, uint32_t attachment = 0) const;
+
+  // Writes the first color attachment as a binary PPM (P6), top row first
+  bool SaveToFile(const std::string &path) const;
 
   const FrameBufferSpecification &GetSpecification() const;
 
@@ -111,5 +138,8 @@ class FrameBuffer {
   uint32_t m_RendererID = 0;
   std::vector<uint32_t> m_ColorAttachments;
   uint32_t m_DepthAttachment = 0;
+
+  uint32_t m_AllocatedWidth = 0;
+  uint32_t m_AllocatedHeight = 0;
 };
 }  // namespace Ham
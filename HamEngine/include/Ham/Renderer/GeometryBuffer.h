@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+#include "Ham/Renderer/Buffer.h"
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace Ham {
+
+// Per draw data read by the indirect vertex shader through gl_DrawID (std430 layout)
+struct IndirectDrawData {
+  math::mat4 Model;
+  math::mat4 Normal;
+  int32_t ID;
+  int32_t FirstIndex;  // where the fragment shader finds the triangles of a WIREFRAME draw
+  int32_t BaseVertex;
+  int32_t Padding;
+};
+
+struct GeometryAllocation {
+  uint32_t FirstVertex = 0;
+  uint32_t VertexCount = 0;
+  uint32_t FirstIndex = 0;
+  uint32_t IndexCount = 0;
+  uint64_t LastUsedFrame = 0;
+  uint32_t Generation = 0;
+  bool Active = false;
+};
+
+// First-fit free list over a linear range, adjacent free blocks are merged on Free()
+class RangeAllocator {
+ public:
+  void Init(uint32_t capacity);
+  void Grow(uint32_t capacity);
+
+  bool Allocate(uint32_t size, uint32_t &offset);
+  void Free(uint32_t offset, uint32_t size);
+
+  uint32_t GetCapacity() const { return m_Capacity; }
+  uint32_t GetUsed() const { return m_Used; }
+
+ private:
+  std::map<uint32_t, uint32_t> m_FreeBlocks;  // offset -> size
+  uint32_t m_Capacity = 0;
+  uint32_t m_Used = 0;
+};
+
+// One shared vertex buffer and one shared index buffer that static meshes are suballocated into,
+// so everything sharing a vertex layout can be drawn with a single glMultiDrawElementsIndirect.
+class GeometryBuffer {
+ public:
+  // Handles carry a generation in the upper bits so a slot recycled by EndFrame() never aliases a stale handle
+  static constexpr uint32_t InvalidHandle = 0xFFFFFFFF;
+  static constexpr uint32_t HandleIndexBits = 20;
+  static constexpr uint32_t HandleIndexMask = (1 << HandleIndexBits) - 1;
+
+  GeometryBuffer() {}
+  ~GeometryBuffer() {}
+
+  void Init(const VertexLayout &layout, uint32_t vertexCapacity = 1 << 16, uint32_t indexCapacity = 1 << 18);
+  void Destroy();
+
+  uint32_t Allocate(const void *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount);
+  // Overwrites vertices [first, first + count) of an allocation in place
+  void UpdateVertices(uint32_t handle, const void *vertices, uint32_t first, uint32_t count);
+  void Free(uint32_t handle);
+
+  bool IsValid(uint32_t handle) const;
+  const GeometryAllocation &Get(uint32_t handle) const;
+
+  // Marks the allocation as used this frame, call it for every live mesh (drawn or not). Allocations left untouched
+  // for maxUnusedFrames get released in EndFrame()
+  DrawElementsIndirectCommand Use(uint32_t handle, uint32_t baseInstance = 0);
+  void EndFrame(uint32_t maxUnusedFrames = 120);
+
+  void Bind() const;
+  void Unbind() const;
+
+  bool IsInitialized() const { return m_isInitialized; }
+  uint32_t GetVertexCapacity() const { return m_Vertices.GetCapacity(); }
+  uint32_t GetIndexCapacity() const { return m_Indices.GetCapacity(); }
+  uint32_t GetVertexCount() const { return m_Vertices.GetUsed(); }
+  uint32_t GetIndexCount() const { return m_Indices.GetUsed(); }
+  uint32_t GetVertexBufferID() const { return m_VertexBufferID; }
+  uint32_t GetIndexBufferID() const { return m_IndexBufferID; }
+
+ private:
+  static uint32_t HandleIndex(uint32_t handle) { return handle & HandleIndexMask; }
+  static uint32_t HandleGeneration(uint32_t handle) { return handle >> HandleIndexBits; }
+
+  void Reserve(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+ private:
+  std::shared_ptr<VertexArray> m_VertexArray;  // the shared one for the layout, see VertexArray::Get
+  uint32_t m_VertexBufferID = 0;
+  uint32_t m_IndexBufferID = 0;
+  uint32_t m_VertexStride = 0;
+
+  RangeAllocator m_Vertices;
+  RangeAllocator m_Indices;
+
+  std::vector<GeometryAllocation> m_Allocations;
+  std::vector<uint32_t> m_FreeHandles;
+
+  uint64_t m_Frame = 0;
+  bool m_isInitialized = false;
+};
+
+}  // namespace Ham
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+
+// std430 layouts, must match include/lights.glsl
+struct ClusterLight {
+  math::vec4 PositionRadius;  // view space position, w = radius
+  math::vec4 ColorIntensity;
+};
+
+struct LightCluster {
+  uint32_t Offset;  // into the light index list
+  uint32_t Count;
+};
+
+// Clustered forward lighting. The view frustum is split into a TilesX * TilesY * Slices grid of froxels with
+// exponentially spaced depth slices, and every point light is binned into the froxels its sphere touches.
+// Slices are binned in parallel on the JobSystem. Everything here is plain CPU code, no GL context is needed.
+class LightClusters {
+ public:
+  static constexpr uint32_t TilesX = 16;
+  static constexpr uint32_t TilesY = 9;
+  static constexpr uint32_t Slices = 24;
+  static constexpr uint32_t ClusterCount = TilesX * TilesY * Slices;
+  // Where the exponential slices start, closer than this nothing is lit anyway. Slice 0 reaches from the camera's
+  // near plane to here, so a tiny camera near plane doesn't use up half the slices
+  static constexpr float MinNear = 0.1f;
+
+  LightClusters() {}
+  ~LightClusters() {}
+
+  // Call order per frame: BeginFrame, AddLight..., Build. near and far are the camera's planes
+  void BeginFrame(const math::mat4 &view, const math::mat4 &projection, float near, float far);
+  void AddLight(const math::vec3 &position, const math::vec3 &color, float intensity, float radius);
+  void Build();
+
+  uint32_t GetSlice(float depth) const;  // depth is the positive view space distance
+  float GetSliceDepth(uint32_t slice) const;
+  static uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t slice) { return (slice * TilesY + y) * TilesX + x; }
+
+  float GetNear() const { return m_Near; }  // max(camera near, MinNear), what the shaders get in uClusterDepthRange
+  float GetFar() const { return m_Far; }
+
+  const std::vector<ClusterLight> &GetLights() const { return m_Lights; }
+  const std::vector<LightCluster> &GetClusters() const { return m_Clusters; }
+  const std::vector<uint32_t> &GetLightIndices() const { return m_Indices; }
+
+  uint32_t GetMaxLightsPerCluster() const { return m_MaxPerCluster; }
+
+ private:
+  struct LightBounds {
+    uint32_t MinSlice, MaxSlice;  // inclusive, MinSlice > MaxSlice if the light is outside the depth range
+  };
+
+  void BinSlice(uint32_t slice);
+  bool Intersects(const ClusterLight &light, uint32_t x, uint32_t y, float nearDepth, float farDepth) const;
+
+ private:
+  math::mat4 m_View;
+  float m_ScaleX = 1.0f;  // projection[0][0] and [1][1], view space x / depth * scale = NDC x
+  float m_ScaleY = 1.0f;
+  float m_CameraNear = 0.1f;
+  float m_Near = 0.1f;  // end of slice 0
+  float m_Far = 100.0f;
+  float m_LogDepthRatio = 1.0f;
+
+  std::vector<ClusterLight> m_Lights;
+  std::vector<LightBounds> m_Bounds;
+
+  std::vector<LightCluster> m_Clusters;
+  std::vector<uint32_t> m_Indices;
+  std::vector<std::vector<uint32_t>> m_SliceIndices;  // written by one job each, concatenated by Build
+
+  uint32_t m_MaxPerCluster = 0;
+};
+
+}  // namespace Ham
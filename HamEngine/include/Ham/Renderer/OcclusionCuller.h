@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+
+// Software occlusion culling. Occluder triangles are rasterized on the CPU into a small depth buffer (split into
+// horizontal bands across the JobSystem), a max-depth pyramid is built from it and bounding boxes are tested
+// against the pyramid. Everything here is plain CPU code, no GL context is needed.
+class OcclusionCuller {
+ public:
+  OcclusionCuller() {}
+  ~OcclusionCuller() {}
+
+  void Init(uint32_t width = 256, uint32_t height = 128);
+
+  void SetEnabled(bool enabled) { m_Enabled = enabled; }
+  bool IsEnabled() const { return m_Enabled; }
+
+  // Call order per frame: BeginFrame, AddOccluder..., Rasterize, then IsVisible from any thread
+  void BeginFrame(const math::mat4 &viewProjection);
+  void AddOccluder(const std::vector<math::vec3> &vertices, const std::vector<uint32_t> &indices, const math::mat4 &model);
+  void Rasterize();
+
+  // Conservative, only returns false if the box is fully behind rasterized occluders
+  bool IsVisible(const math::vec3 &boundsMin, const math::vec3 &boundsMax, const math::mat4 &model) const;
+
+  uint32_t GetWidth() const { return m_Width; }
+  uint32_t GetHeight() const { return m_Height; }
+  const std::vector<float> &GetDepthBuffer() const { return m_Depth; }
+
+  size_t GetOccluderTriangleCount() const { return m_Triangles.size(); }
+  uint32_t GetTestedCount() const { return m_Tested; }
+  uint32_t GetCulledCount() const { return m_Culled; }
+
+ private:
+  struct ScreenTriangle {
+    float X[3], Y[3], Z[3];
+    int MinY, MaxY;
+  };
+
+  struct HiZLevel {
+    uint32_t Width, Height;
+    std::vector<float> Depth;  // farthest depth of the texels below
+  };
+
+  void AddClippedTriangle(const math::vec4 &a, const math::vec4 &b, const math::vec4 &c);
+  void RasterizeBand(int yBegin, int yEnd);
+  void RasterizeTriangle(const ScreenTriangle &triangle, int yBegin, int yEnd);
+  void BuildHiZ();
+
+ private:
+  uint32_t m_Width = 0;
+  uint32_t m_Height = 0;
+
+  math::mat4 m_ViewProjection;
+  std::vector<ScreenTriangle> m_Triangles;
+  std::vector<float> m_Depth;
+  std::vector<HiZLevel> m_HiZ;
+
+  mutable std::atomic_uint32_t m_Tested = 0;
+  mutable std::atomic_uint32_t m_Culled = 0;
+
+  bool m_Enabled = true;
+  bool m_HasOccluders = false;
+};
+
+}  // namespace Ham
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Ham {
+class Shader;
+
+enum class CullMode : uint8_t {
+  NONE,
+  BACK,
+};
+
+enum class BlendMode : uint8_t {
+  NONE,
+  ALPHA,     // src alpha, one minus src alpha
+  ADDITIVE,  // src alpha, one
+};
+
+enum class PolygonMode : uint8_t {
+  FILL,
+  LINE,
+};
+
+// Everything a draw needs bound besides its buffers and uniforms
+struct PipelineState {
+  Shader *Program = nullptr;
+  uint32_t ProgramHandle = 0;  // Program->GetHandle(), filled in by PipelineCache::Get. States are told apart by it
+  bool DepthTest = true;
+  bool DepthWrite = true;
+  bool WriteEntityID = true;  // color attachment 1, read back by the object picker
+  CullMode Cull = CullMode::NONE;
+  BlendMode Blend = BlendMode::NONE;
+  PolygonMode Polygon = PolygonMode::FILL;
+
+  // From RENDER_STATE_* flags, see RenderCommand.h
+  static PipelineState FromFlags(Shader *program, uint32_t flags);
+
+  bool operator==(const PipelineState &other) const;
+  bool operator!=(const PipelineState &other) const { return !(*this == other); }
+};
+
+using PipelineID = uint16_t;
+
+// Interns pipeline states so draws only carry a small ID, equal states always get the same ID. Binding an ID on the
+// render thread only issues the GL calls for the parts that differ from the last bound state.
+class PipelineCache {
+ public:
+  static constexpr uint32_t MaxPipelines = 4096;
+
+  // Safe to call from any thread, IDs stay valid for the lifetime of the application. Interning hashes and locks, so
+  // look IDs up once when what they depend on changes and keep them (see Component::ShaderList)
+  static PipelineID Get(const PipelineState &state);
+  static PipelineID Get(Shader *program, uint32_t flags) { return Get(PipelineState::FromFlags(program, flags)); }
+  // Lock free, states never move or change once added. Program is only valid while its Shader is alive
+  static const PipelineState &GetState(PipelineID id) { return s_States[id]; }
+  static uint32_t GetCount() { return s_Count.load(std::memory_order_acquire); }
+
+  // Render thread only
+  static void Bind(PipelineID id);
+  // Call after GL state was changed without going through Bind (or a program was relinked), the next Bind then sets
+  // everything
+  static void Invalidate() { s_HasCurrent = false; }
+
+ private:
+  struct Hasher {
+    size_t operator()(const PipelineState &state) const;
+  };
+
+  static std::array<PipelineState, MaxPipelines> s_States;  // indexed by ID, append only
+  static std::atomic_uint32_t s_Count;
+  static std::unordered_map<PipelineState, PipelineID, Hasher> s_IDs;
+  static std::mutex s_Mutex;  // for adding states
+
+  static PipelineState s_Current;
+  static PipelineID s_CurrentID;
+  static bool s_HasCurrent;
+};
+
+}  // namespace Ham
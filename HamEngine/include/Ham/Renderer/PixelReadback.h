@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+class FrameBuffer;
+
+// Asynchronous glReadPixels through a small ring of pixel pack buffers. Requests are resolved in order
+// once their fence has signalled (normally 1-2 frames later), Poll() never blocks on the GPU.
+class PixelReadback {
+ public:
+  static constexpr uint32_t RingSize = 3;
+
+  PixelReadback() {}
+  ~PixelReadback() {}
+
+  void Init(uint32_t maxWidth, uint32_t maxHeight, uint32_t bytesPerPixel = 4);
+  void Destroy();
+
+  // Queues a read of the given region, returns false if every slot is still in flight.
+  // format/type are the glReadPixels ones and must produce bytesPerPixel bytes per pixel.
+  bool Request(const FrameBuffer &frameBuffer, uint32_t attachment, int x, int y, int width, int height, uint32_t format = GL_RGBA, uint32_t type = GL_UNSIGNED_BYTE, uint64_t userData = 0);
+  // Returns the oldest finished request, if any
+  bool Poll(std::vector<unsigned char> &pixels, uint64_t &userData);
+
+  uint32_t GetPendingCount() const { return m_Pending; }
+  bool IsInitialized() const { return m_isInitialized; }
+
+ private:
+  struct Slot {
+    uint32_t BufferID = 0;
+    GLsync Fence = nullptr;
+    size_t Size = 0;
+    uint64_t UserData = 0;
+  };
+
+  std::array<Slot, RingSize> m_Slots;
+  uint32_t m_Head = 0;
+  uint32_t m_Tail = 0;
+  uint32_t m_Pending = 0;
+  size_t m_Capacity = 0;
+  uint32_t m_BytesPerPixel = 4;
+
+  bool m_isInitialized = false;
+};
+
+}  // namespace Ham
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+#include "Ham/Renderer/PipelineState.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+class Shader;
+class VertexArray;
+
+// Shorthand for the common pipeline states, see PipelineState::FromFlags
+enum RenderStateFlags : uint32_t {
+  RENDER_STATE_NONE = 0,
+  RENDER_STATE_DEPTH_TEST = 1 << 0,
+  RENDER_STATE_CULL_BACK = 1 << 1,
+  RENDER_STATE_ALPHA_BLEND = 1 << 2,
+  RENDER_STATE_WIREFRAME = 1 << 3,
+  // fill and wireframe in one pass by a WIREFRAME shader variant, sets no GL state by itself
+  RENDER_STATE_WIREFRAME_OVERLAY = 1 << 4,
+};
+
+// Uniforms shared by every draw of a frame
+struct FrameData {
+  math::mat4 View;
+  math::mat4 Projection;
+  math::vec3 AmbientLight;
+  math::vec2 ClusterDepthRange;  // near and far plane of the light cluster grid
+  math::vec3 ObjectColor;
+  math::vec3 WireframeColor;
+  math::vec2 Resolution;
+  float Time;
+};
+
+// Uniforms that change per draw
+struct ObjectData {
+  math::mat4 Model;
+  math::mat4 Normal;  // transpose(inverse(Model))
+  int32_t ID;
+  int32_t IsWireframe;
+};
+
+enum class RenderCommandType : uint8_t {
+  BIND_PIPELINE,
+  BIND_VERTEX_ARRAY,
+  BIND_VERTEX_BUFFERS,
+  BIND_STORAGE_BUFFER,
+  SET_FRAME_DATA,
+  SET_OBJECT_DATA,
+  DRAW_ELEMENTS,
+  DRAW_LINES_INSTANCED,
+};
+
+struct RenderCommand {
+  RenderCommandType Type;
+  union {
+    PipelineID Pipeline;
+    const VertexArray *VAO;
+    struct {
+      uint32_t Vertex;
+      uint32_t Index;
+    } VertexBuffers;  // attached to the last bound vertex array
+    struct {
+      uint32_t Binding;
+      uint32_t Buffer;
+    } StorageBuffer;
+    uint32_t DataIndex;  // into the owning list's FrameData/ObjectData arrays
+    struct {
+      uint32_t Count;
+      uint32_t FirstIndex;
+    } Draw;
+    struct {
+      uint32_t Count;
+      uint32_t Instances;
+    } InstancedDraw;
+  };
+};
+
+// Flat list of POD render commands. Recording never touches GL so lists can be built on any thread
+// (or without a context at all) and replayed later by RenderCommandList::Execute on the render thread.
+class RenderCommandList {
+ public:
+  static constexpr uint32_t MaxStorageBufferBindings = 4;
+
+  void Clear();
+
+  // program and fixed function state, see PipelineCache
+  void BindPipeline(PipelineID pipeline);
+  // vertex arrays are shared between meshes of the same layout, only the buffers change between them
+  void BindVertexArray(const VertexArray *vertexArray, uint32_t vertexBuffer, uint32_t indexBuffer);
+  void BindStorageBuffer(uint32_t binding, uint32_t buffer);
+  void SetFrameData(const FrameData &data);
+  void SetObjectData(const ObjectData &data);
+  void DrawElements(uint32_t count, uint32_t firstIndex = 0);
+  // non-indexed, the shader builds its vertices from gl_VertexID and gl_InstanceID
+  void DrawLinesInstanced(uint32_t count, uint32_t instances);
+
+  const std::vector<RenderCommand> &GetCommands() const { return m_Commands; }
+  const std::vector<FrameData> &GetFrameData() const { return m_FrameData; }
+  const std::vector<ObjectData> &GetObjectData() const { return m_ObjectData; }
+  size_t GetDrawCount() const { return m_DrawCount; }
+
+  // GL backend, render thread only
+  void Execute() const;
+  static void ApplyFrameData(Shader &shader, const FrameData &data);
+
+ private:
+  std::vector<RenderCommand> m_Commands;
+  std::vector<FrameData> m_FrameData;
+  std::vector<ObjectData> m_ObjectData;
+
+  // redundant binds are dropped while recording
+  PipelineID m_CurrentPipeline = 0;
+  bool m_HasPipeline = false;
+  const VertexArray *m_CurrentVertexArray = nullptr;
+  uint32_t m_CurrentVertexBuffer = 0;
+  uint32_t m_CurrentIndexBuffer = 0;
+  uint32_t m_CurrentStorageBuffers[MaxStorageBufferBindings] = {};
+
+  size_t m_DrawCount = 0;
+};
+
+}  // namespace Ham
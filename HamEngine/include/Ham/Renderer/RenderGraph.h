@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Ham/Renderer/FrameBuffer.h"
+#include "Ham/Renderer/RenderTargetPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Ham {
+
+using RenderGraphResource = uint32_t;
+
+class RenderGraph;
+
+// Handed to a pass's setup function to declare what the pass touches
+class RenderGraphBuilder {
+ public:
+  // A framebuffer that only lives for this frame, borrowed from the RenderTargetPool
+  RenderGraphResource Create(const std::string &name, const FrameBufferSpecification &spec);
+
+  void Read(RenderGraphResource resource);
+  // clear is a mask of AttachmentType bits cleared before the pass runs. Attachments that are not cleared keep
+  // their contents, so the write also counts as a read of whatever an earlier pass left there.
+  void Write(RenderGraphResource resource, uint32_t clear = 0);
+  // The pass does something the graph can't see (readbacks, presenting), it is never culled
+  void SideEffect();
+
+ private:
+  RenderGraphBuilder(RenderGraph &graph, uint32_t pass) : m_Graph(graph), m_Pass(pass) {}
+
+  RenderGraph &m_Graph;
+  uint32_t m_Pass;
+
+  friend class RenderGraph;
+};
+
+// Rebuilt every frame: Reset, Import/AddPass, Compile, Execute. Compile drops passes whose writes are never read,
+// lets transient resources with disjoint lifetimes share one framebuffer, clears transients whose first use would
+// otherwise load undefined contents and discards attachments after their last use.
+class RenderGraph {
+ public:
+  using SetupFunction = std::function<void(RenderGraphBuilder &)>;
+  using ExecuteFunction = std::function<void(RenderGraph &)>;
+
+  RenderGraph() {}
+  ~RenderGraph() {}
+
+  void Reset();
+
+  // frameBuffer == nullptr is the window's default framebuffer. Writes to imported resources are always kept;
+  // discard lists the attachments (AttachmentType bits) that are not needed after the last pass using it.
+  RenderGraphResource Import(const std::string &name, FrameBuffer *frameBuffer, uint32_t discard = 0);
+  void AddPass(const std::string &name, const SetupFunction &setup, const ExecuteFunction &execute);
+
+  void Compile();
+  void Execute(RenderTargetPool &pool);
+
+  // Only valid while the graph executes
+  FrameBuffer *GetFrameBuffer(RenderGraphResource resource) const;
+
+  uint32_t GetPassCount() const { return m_PassCount; }
+  uint32_t GetCulledPassCount() const { return m_CulledPassCount; }
+  uint32_t GetTransientCount() const { return m_TransientCount; }
+  uint32_t GetPhysicalTargetCount() const { return m_PhysicalTargetCount; }
+
+ private:
+  struct Resource {
+    std::string Name;
+    FrameBufferSpecification Spec;
+    bool Imported = false;
+    FrameBuffer *Target = nullptr;  // imported framebuffer, or the physical one while executing
+    uint32_t Discard = 0;
+
+    // filled in by Compile
+    int FirstPass = -1;
+    int LastPass = -1;
+    int Physical = -1;
+    uint32_t InsertedClear = 0;
+  };
+
+  struct Pass {
+    std::string Name;
+    ExecuteFunction Execute;
+    std::vector<RenderGraphResource> Reads;
+    std::vector<std::pair<RenderGraphResource, uint32_t>> Writes;  // resource, clear mask
+    bool SideEffect = false;
+    bool Culled = false;
+  };
+
+  struct PhysicalTarget {
+    FrameBufferSpecification Spec;
+    int LastPass;
+    FrameBuffer *Target = nullptr;
+  };
+
+  static uint32_t GetAttachmentMask(const Resource &resource);
+  static bool CanAlias(const FrameBufferSpecification &a, const FrameBufferSpecification &b);
+  void ClearTarget(Resource &resource, uint32_t mask) const;
+  void DiscardTarget(Resource &resource, uint32_t mask) const;
+
+  std::vector<Resource> m_Resources;
+  std::vector<Pass> m_Passes;
+  std::vector<PhysicalTarget> m_PhysicalTargets;
+  bool m_Compiled = false;
+
+  uint32_t m_PassCount = 0;
+  uint32_t m_CulledPassCount = 0;
+  uint32_t m_TransientCount = 0;
+  uint32_t m_PhysicalTargetCount = 0;
+
+  friend class RenderGraphBuilder;
+};
+
+}  // namespace Ham
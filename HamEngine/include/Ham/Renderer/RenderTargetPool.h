@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Ham/Renderer/FrameBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Ham {
+
+// Framebuffers for short-lived passes. A pass borrows a target matching its formats for the current frame and
+// every borrow is returned by EndFrame. Targets are reused across frames and sizes through FrameBuffer's size
+// classes, targets nobody asked for in a while are deleted.
+class RenderTargetPool {
+ public:
+  static constexpr uint32_t MaxIdleFrames = 120;
+
+  RenderTargetPool() {}
+  ~RenderTargetPool() {}
+
+  // spec.Width/Height is the size the pass renders at, valid until Release or EndFrame
+  FrameBuffer *Acquire(const FrameBufferSpecification &spec);
+  // Optional, lets a later pass of the same frame reuse the target
+  void Release(FrameBuffer *target);
+
+  void EndFrame();
+  void Clear();
+
+  uint32_t GetTargetCount() const { return (uint32_t)m_Entries.size(); }
+  uint32_t GetBorrowedCount() const;
+  uint32_t GetAllocationCount() const { return m_Allocations; }  // total since startup
+
+ private:
+  struct Entry {
+    std::unique_ptr<FrameBuffer> Target;
+    uint64_t LastUsedFrame = 0;
+    bool Borrowed = false;
+  };
+
+  static bool IsCompatible(const FrameBufferSpecification &a, const FrameBufferSpecification &b);
+
+  std::vector<Entry> m_Entries;
+  uint64_t m_Frame = 0;
+  uint32_t m_Allocations = 0;
+};
+
+}  // namespace Ham
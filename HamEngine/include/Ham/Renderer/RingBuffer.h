@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Ham/Debug/RenderStats.h"
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Ham {
+
+// Persistently mapped buffer split into FrameCount sections. The CPU writes into the current section while the GPU
+// is still reading the previous ones, a fence per section keeps us from overwriting data that is in flight.
+class RingBuffer {
+ public:
+  static constexpr uint32_t FrameCount = 3;
+
+  RingBuffer() {}
+  ~RingBuffer() {}
+
+  void Init(uint32_t target, size_t frameSize);
+  void Destroy();
+
+  // Waits on the fence of the section about to be reused, call once per frame before any Allocate()
+  void BeginFrame();
+  // Places the fence for the current section, call once all draws reading this frame's data are submitted
+  void EndFrame();
+
+  // Returns a pointer into mapped memory and the offset of it from the start of the buffer,
+  // nullptr if the section is full (the ring grows at the next BeginFrame())
+  void *Allocate(size_t size, size_t &offset);
+
+  template <typename T>
+  bool Write(const T *data, size_t count, size_t &offset)
+  {
+    void *ptr = Allocate(count * sizeof(T), offset);
+    if (ptr == nullptr)
+      return false;
+    memcpy(ptr, data, count * sizeof(T));
+    RenderStats::Add(RenderCounter::BUFFER_UPLOADS);
+    RenderStats::Add(RenderCounter::UPLOAD_BYTES, count * sizeof(T));
+    return true;
+  }
+
+  template <typename T>
+  bool Write(const std::vector<T> &data, size_t &offset) { return Write(data.data(), data.size(), offset); }
+
+  void Bind() const { glBindBuffer(m_Target, m_BufferID); }
+  void Bind(uint32_t target) const { glBindBuffer(target, m_BufferID); }
+  void Unbind() const { glBindBuffer(m_Target, 0); }
+  void BindRange(uint32_t target, uint32_t index, size_t offset, size_t size) const { glBindBufferRange(target, index, m_BufferID, offset, size); }
+
+  bool IsInitialized() const { return m_isInitialized; }
+  uint32_t GetID() const { return m_BufferID; }
+  size_t GetFrameSize() const { return m_FrameSize; }
+  size_t GetFrameUsed() const { return m_Head; }
+
+  // time spent blocked in BeginFrame() waiting for the GPU, in milliseconds
+  float GetLastWaitTime() const { return m_LastWaitTime; }
+  float GetMaxWaitTime() const { return m_MaxWaitTime; }
+  float GetTotalWaitTime() const { return m_TotalWaitTime; }
+  uint64_t GetStallCount() const { return m_StallCount; }
+  void ResetWaitStats();
+
+ private:
+  void Create(size_t frameSize);
+  void WaitForSection(uint32_t section);
+
+ private:
+  uint32_t m_BufferID = 0;
+  uint32_t m_Target = 0;
+  uint8_t *m_Mapped = nullptr;
+
+  size_t m_FrameSize = 0;
+  size_t m_Alignment = 1;
+  size_t m_Head = 0;
+  size_t m_Overflow = 0;
+  uint32_t m_Section = 0;
+
+  std::array<GLsync, FrameCount> m_Fences = {};
+
+  float m_LastWaitTime = 0.0f;
+  float m_MaxWaitTime = 0.0f;
+  float m_TotalWaitTime = 0.0f;
+  uint64_t m_StallCount = 0;
+
+  bool m_isInitialized = false;
+};
+
+}  // namespace Ham
@@ -2,6 +2,7 @@
 
 #include "Ham/Core/Math.h"
 #include "Ham/Util/File.h"
+#include "Ham/Renderer/ShaderCompiler.h"
 
 #include <atomic>
 #include <chrono>
@@ -9,18 +10,27 @@
 #include <unordered_map>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 namespace Ham {
 class Application;
 class Shader {
  public:
-  Shader(std::string vertexPath, std::string fragmentPath, std::string geometryPath = "");
+  // Nothing is read or compiled here, that happens on the render thread's next PerformReload or in
+  // WaitUntilReady, so variants can be created from any thread. defines are "NAME" or "NAME=VALUE".
+  Shader(std::string vertexPath, std::string fragmentPath, std::string geometryPath = "", std::vector<std::string> defines = {});
   ~Shader();
 
   void Bind() const;
   void Unbind() const;
   void Reload();
-  void PerformReload();
+  void PerformReload();  // called every frame on the render thread, also swaps in finished compiles
+
+  bool IsReady() const { return m_RendererID != 0; }
+  // Unique per Shader object and never reused, unlike its address or GL program (which changes on reload)
+  uint32_t GetHandle() const { return m_Handle; }
+  void WaitUntilReady();
 
   void SetUniform1i(const std::string &name, int value);
   void SetUniform2i(const std::string &name, math::ivec2 value);
@@ -37,20 +47,34 @@ class Shader {
 
  private:
   unsigned int m_RendererID = 0;
+  uint32_t m_Handle;
   std::unordered_map<std::string, int> m_UniformLocationCache;
 
-  unsigned int CompileShader(unsigned int type, const std::string &source);
-  unsigned int CreateShader(const std::string &vertexShader, const std::string &fragmentShader, const std::string &geometryShader = "");
+  void SubmitCompile();
+  void ApplyCompile();
+  void WatchDependencies(const std::vector<std::string> &dependencies);
+  std::string GetDescription() const;
   int GetUniformLocation(const std::string &name);
 
+  std::shared_ptr<ShaderCompileJob> m_Compile;
+
   std::string m_VertexSourcePath;
   std::string m_FragmentSourcePath;
   std::string m_GeometrySourcePath;
+  std::vector<std::string> m_Defines;
+
+  // every file the last preprocess read, indexed by #line source number
+  std::vector<std::string> m_Dependencies;
+  std::vector<uint32_t> m_WatchIDs;
 
   std::chrono::time_point<std::chrono::system_clock> m_LastReloadTime;
-  std::atomic_bool m_ShouldReload = false;
+  std::atomic_bool m_ShouldReload = true;  // also set until the first compile is submitted
+
+  static void PerformReloads(bool wait);
 
   static std::vector<Shader *> s_Shaders;
+  static std::mutex s_ShadersMutex;
+  static std::atomic_uint32_t s_NextHandle;
 
   friend class Application;
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Ham {
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Entries are keyed by a hash of every stage's
+// source plus the driver's vendor/renderer/version strings, so a driver update or an edited shader simply misses.
+class ShaderCache {
+ public:
+  static void Init(const std::string &directory);
+
+  static bool IsEnabled() { return s_Enabled; }
+
+  static uint64_t GetKey(const std::vector<std::string> &sources);
+
+  // Returns a linked program, or 0 if there is no usable entry (stale entries are deleted)
+  static unsigned int Load(uint64_t key);
+  static void Store(uint64_t key, unsigned int program);
+
+  static uint32_t GetHitCount() { return s_Hits; }
+  static uint32_t GetMissCount() { return s_Misses; }
+
+ private:
+  static std::string GetPath(uint64_t key);
+
+ private:
+  static std::string s_Directory;
+  static std::string s_Driver;
+  static bool s_Enabled;
+  static uint32_t s_Hits;
+  static uint32_t s_Misses;
+};
+
+}  // namespace Ham
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct GLFWwindow;
+
+namespace Ham {
+
+enum class ShaderCompileStatus {
+  PENDING,
+  DONE,
+  FAILED,
+};
+
+struct ShaderCompileJob {
+  std::string Sources[3];  // vertex, fragment, geometry (optional)
+  uint64_t CacheKey = 0;
+
+  unsigned int Program = 0;  // valid once Status is DONE
+  unsigned int Stages[3] = {0, 0, 0};
+  std::atomic<ShaderCompileStatus> Status = ShaderCompileStatus::PENDING;
+};
+
+// Compiles and links programs without blocking the caller. Everything is submitted first and finished later:
+// with KHR/ARB_parallel_shader_compile the driver compiles on its own threads and GL_COMPLETION_STATUS is polled,
+// otherwise a worker thread compiles on a context shared with the window. Without either, work is still
+// submitted up front and only the status queries are deferred.
+class ShaderCompiler {
+ public:
+  static void Init(GLFWwindow *sharedContext = nullptr);
+  static void Shutdown();
+
+  static std::shared_ptr<ShaderCompileJob> Submit(const std::string &vertex, const std::string &fragment, const std::string &geometry = "");
+
+  // Poll never blocks; both have to be called with the main context current
+  static ShaderCompileStatus Poll(ShaderCompileJob &job);
+  static ShaderCompileStatus Wait(ShaderCompileJob &job);
+
+  static bool IsDriverParallel() { return s_DriverParallel; }
+  static bool HasWorker() { return s_Worker.joinable(); }
+
+ private:
+  static void StartCompile(ShaderCompileJob &job);
+  static bool FinishCompile(ShaderCompileJob &job);
+  static void WorkerMain(GLFWwindow *context);
+
+ private:
+  static bool s_DriverParallel;
+
+  static std::thread s_Worker;
+  static std::deque<std::shared_ptr<ShaderCompileJob>> s_Queue;
+  static std::mutex s_Mutex;
+  static std::condition_variable s_QueueCondition;
+  static std::condition_variable s_DoneCondition;
+  static bool s_Stopping;
+};
+
+}  // namespace Ham
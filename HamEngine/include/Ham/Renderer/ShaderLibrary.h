@@ -3,14 +3,37 @@
 #include "Ham/Core/Base.h"
 #include "Ham/Renderer/Shader.h"
 
+#include <mutex>
+
 namespace Ham {
+
+// A named set of shader files plus the defines it is always built with. Options are the extra defines a
+// caller may ask for; each combination becomes its own program, created the first time it is requested.
+struct ShaderTemplate {
+  std::string VertexPath;
+  std::string FragmentPath;
+  std::string GeometryPath;
+  std::vector<std::string> Defines;
+  std::vector<std::string> Options;
+};
+
 class ShaderLibrary {
  public:
   static void Init();
+
+  static void Register(std::string name, ShaderTemplate shaderTemplate);
+
+  // Compiles and waits for the base variant, the main context has to be current
   static std::shared_ptr<Shader> Load(std::string name, std::string vertexPath, std::string fragmentPath, std::string geometryPath = "");
-  static std::shared_ptr<Shader> Get(std::string name);
+
+  // Returns the variant of a registered template, creating it if needed, or nullptr if the template is unknown or
+  // does not support one of the options. Safe to call from any thread; a new variant is compiled by the render
+  // thread, so check IsReady() before drawing with it.
+  static std::shared_ptr<Shader> Get(const std::string &name, std::vector<std::string> options = {});
 
  private:
-  static std::unordered_map<std::string, std::shared_ptr<Shader>> s_Shaders;
+  static std::unordered_map<std::string, ShaderTemplate> s_Templates;
+  static std::unordered_map<std::string, std::shared_ptr<Shader>> s_Variants;  // keyed by name and sorted options
+  static std::mutex s_Mutex;
 };
 }  // namespace Ham
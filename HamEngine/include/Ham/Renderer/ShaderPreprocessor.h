@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Ham {
+
+// Expands #include "file" (relative to the including file, honouring #pragma once) and injects defines right
+// after #version. Every file is tagged with a #line marker whose source number is its index in dependencies,
+// so compiler errors like "2(14)" point at line 14 of dependencies[2].
+class ShaderPreprocessor {
+ public:
+  // defines are "NAME" or "NAME=VALUE". Files read are appended to dependencies (existing entries are reused),
+  // also when processing fails, so a broken include can still be watched.
+  static bool Process(const std::string &path, const std::vector<std::string> &defines, std::string &output, std::vector<std::string> &dependencies);
+
+ private:
+  static bool ProcessFile(const std::string &path, std::string &output, std::vector<std::string> &dependencies, std::vector<std::string> &onceFiles, const std::string &defines, int depth);
+};
+
+}  // namespace Ham
@@ -4,16 +4,24 @@
 #include "Ham/Util/TimeStep.h"
 #include "Ham/Util/UUID.h"
 #include "Ham/Renderer/Buffer.h"
+#include "Ham/Renderer/GeometryBuffer.h"
+#include "Ham/Renderer/PipelineState.h"
 #include "Ham/Renderer/Shader.h"
 #include "Ham/Renderer/ShaderLibrary.h"
+#include "Ham/Scene/Particles.h"
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <functional>
+#include <memory>
 
 namespace Ham {
 class Entity;
 class Scene;
+class Heightfield;
 struct NativeScript {
   std::string Name;
   UUID ID;
@@ -133,8 +141,24 @@ struct Transform {
   math::vec3 backward() { return -forward(); }
 };
 
+// The variants and pipeline IDs one shader of a ShaderList needs for its entity's current flags. Filled in on the
+// render thread by Systems::ResolveShaders when the names or flags change, so recording (possibly on worker
+// threads) never goes through ShaderLibrary or PipelineCache. Variants that are not needed are left empty.
+struct ResolvedShader {
+  std::shared_ptr<Shader> Program;
+  std::shared_ptr<Shader> Overlay;  // WIREFRAME, fill and wireframe in one draw
+  std::shared_ptr<Shader> Indirect;
+  std::shared_ptr<Shader> IndirectOverlay;
+
+  PipelineID Fill = 0, Wireframe = 0, OverlayFill = 0;
+  PipelineID IndirectFill = 0, IndirectWireframe = 0, IndirectOverlayFill = 0;
+  bool DebugNormals = false;  // "vertex-normal", lines built from the vertex buffer
+};
+
 struct ShaderList {
   std::vector<std::string> Names;
+  std::vector<ResolvedShader> Resolved;  // one per name, see Systems::ResolveShaders
+  uint32_t ResolvedKey = 0xFFFFFFFF;     // the flags Resolved was built for
 
   ShaderList() {}
   ShaderList(const ShaderList &other) : Names(other.Names) {}
@@ -144,12 +168,14 @@ struct ShaderList {
     HAM_CORE_ASSERT(!Has(name), fmt::format("Shader {0} already added!", name));
     HAM_CORE_ASSERT(::Ham::ShaderLibrary::Get(name) != nullptr, fmt::format("Shader {0} not found!", name));
     Names.push_back(name);
+    ResolvedKey = 0xFFFFFFFF;
   }
 
   void Remove(std::string name)
   {
     HAM_CORE_ASSERT(Has(name), fmt::format("Shader {0} not added!", name));
     Names.erase(std::remove(Names.begin(), Names.end(), name), Names.end());
+    ResolvedKey = 0xFFFFFFFF;
   }
 
   std::shared_ptr<::Ham::Shader> Get(std::string name)
@@ -222,20 +248,43 @@ struct VertexData {
   math::vec3 Position;
   math::vec3 Normal;
   // math::vec2 TexCoord;
+
+  static VertexLayout GetLayout()
+  {
+    return VertexLayout(sizeof(VertexData)).Add(offsetof(VertexData, Position), 3).Add(offsetof(VertexData, Normal), 3);
+  }
 };
 
+// shaders that read vertex buffers as storage buffers (wireframe.glsl, normals.vert) assume the std430 layout
+static_assert(sizeof(VertexData) == 32 && offsetof(VertexData, Normal) == 16, "VertexData no longer matches the std430 vertex struct in the shaders");
+
 struct Mesh {
   VertexBuffer<VertexData> Vertices;
   IndexBuffer Indices;
-  VertexArray VAO;
+  std::shared_ptr<VertexArray> VAO;  // shared by every mesh with this vertex layout
 
   bool ShowWireframe = false;
   bool ShowFill = true;
   bool AlphaBlending = false;
   bool BackfaceCulling = true;
 
+  // suballocation inside Application::GetGeometryBuffer(), (re)uploaded lazily by the indirect renderer
+  uint32_t GeometryHandle = GeometryBuffer::InvalidHandle;
+  bool GeometryDirty = true;
+
+  // local space bounding box, used by the occlusion culler
+  math::vec3 BoundsMin = {0.0f, 0.0f, 0.0f};
+  math::vec3 BoundsMax = {0.0f, 0.0f, 0.0f};
+
   Mesh() {}
-  Mesh(const Mesh &other) : Vertices(other.Vertices), Indices(other.Indices) {}  // VBO(other.VBO)
+  // a copy uploads its own buffers, see Buffer
+  Mesh(const Mesh &other) : VAO(other.VAO)
+  {
+    if (other.Vertices.IsInitialized() && other.Indices.IsInitialized())
+      Recalculate(other.Vertices.GetData(), other.Indices.GetData());
+  }
+  Mesh(Mesh &&other) = default;
+  Mesh &operator=(Mesh &&other) = default;
   Mesh(const std::vector<VertexData> &verticies, const std::vector<uint32_t> &indicies)
   {
     Recalculate(verticies, indicies);
@@ -243,27 +292,110 @@ struct Mesh {
 
   void Recalculate(const std::vector<VertexData> &verticies, const std::vector<uint32_t> &indicies)
   {
-    if (!VAO.IsInitialized()) {
-      VAO.Create();
-    }
-    VAO.Bind();
+    if (VAO == nullptr)
+      VAO = VertexArray::Get(VertexData::GetLayout());
 
-    if (!Indices.IsInitialized()) {
+    if (!Indices.IsInitialized())
       Indices.Create();
-    }
-    Indices.Bind();
     Indices.SetData(indicies);
 
-    if (!Vertices.IsInitialized()) {
+    if (!Vertices.IsInitialized())
       Vertices.Create();
-    }
-    Vertices.Bind();
     Vertices.SetData(verticies);
 
-    // VBO.Unbind();
-    // Verticies.Unbind();
-    // Indicies.Unbind();
+    GeometryDirty = true;
+
+    BoundsMin = BoundsMax = verticies.empty() ? math::vec3(0.0f) : verticies[0].Position;
+    for (auto &vertex : verticies) {
+      BoundsMin = math::min(BoundsMin, vertex.Position);
+      BoundsMax = math::max(BoundsMax, vertex.Position);
+    }
   }
+
+  // Uploads the ranges edited through Vertices.Modify() to the mesh's own buffer and its geometry buffer copy.
+  // The bounds only grow here, a full Recalculate() tightens them again.
+  void FlushVertices(GeometryBuffer &geometry)
+  {
+    if (!Vertices.IsDirty())
+      return;
+
+    auto &vertices = Vertices.GetData();
+    for (auto &range : Vertices.Flush()) {
+      for (size_t i = range.First; i < range.First + range.Count; i++) {
+        BoundsMin = math::min(BoundsMin, vertices[i].Position);
+        BoundsMax = math::max(BoundsMax, vertices[i].Position);
+      }
+
+      if (geometry.IsValid(GeometryHandle))  // otherwise it is uploaded in full on first use
+        geometry.UpdateVertices(GeometryHandle, vertices.data() + range.First, (uint32_t)range.First, (uint32_t)range.Count);
+    }
+  }
+};
+
+// Low poly stand-in rasterized into the CPU occlusion buffer, should stay inside the visible mesh
+struct Occluder {
+  std::vector<math::vec3> Vertices;
+  std::vector<uint32_t> Indices;
+
+  Occluder() {}
+  Occluder(const Occluder &other) : Vertices(other.Vertices), Indices(other.Indices) {}
+  Occluder(const std::vector<math::vec3> &vertices, const std::vector<uint32_t> &indices) : Vertices(vertices), Indices(indices) {}
+  Occluder(const std::vector<VertexData> &vertices, const std::vector<uint32_t> &indices) : Indices(indices)
+  {
+    Vertices.reserve(vertices.size());
+    for (auto &vertex : vertices)
+      Vertices.push_back(vertex.Position);
+  }
+};
+
+// Point light at the entity's position, falls off to zero at Radius
+struct Light {
+  math::vec3 Color = math::vec3(1.0f, 1.0f, 1.0f);
+  float Intensity = 1.0f;
+  float Radius = 5.0f;
+
+  Light() {}
+  Light(const Light &other) : Color(other.Color), Intensity(other.Intensity), Radius(other.Radius) {}
+  Light(const math::vec3 &color, float intensity, float radius) : Color(color), Intensity(intensity), Radius(radius) {}
+};
+
+// Spawns particles at the entity's position along its local up axis, they are simulated in world space so they
+// trail behind a moving emitter. All emitters are drawn together by Systems::RenderParticles.
+struct ParticleEmitter {
+  float Rate = 1000.0f;  // particles per second
+  float Lifetime = 2.0f;  // seconds
+  float Speed = 5.0f;
+  float Spread = 0.2f;  // 0 is a ray, 1 about a hemisphere
+  math::vec3 Gravity = math::down() * 9.81f;
+
+  math::vec4 StartColor = math::vec4(1.0f, 0.8f, 0.3f, 1.0f);
+  math::vec4 EndColor = math::vec4(1.0f, 0.1f, 0.0f, 0.0f);
+  float StartSize = 0.05f;
+  float EndSize = 0.02f;
+
+  bool Emitting = true;  // live particles finish their life when turned off
+
+  std::shared_ptr<ParticlePool> Pool = std::make_shared<ParticlePool>();
+
+  ParticleEmitter() {}
+  // copies get their own particles
+  ParticleEmitter(const ParticleEmitter &other)
+      : Rate(other.Rate), Lifetime(other.Lifetime), Speed(other.Speed), Spread(other.Spread), Gravity(other.Gravity), StartColor(other.StartColor), EndColor(other.EndColor), StartSize(other.StartSize), EndSize(other.EndSize), Emitting(other.Emitting) {}
+  ParticleEmitter(float rate, float lifetime, float speed) : Rate(rate), Lifetime(lifetime), Speed(speed) {}
+
+  // the pool never has to drop a spawn at a steady rate
+  uint32_t GetCapacity() const { return (uint32_t)std::ceil(std::max(Rate, 0.0f) * std::max(Lifetime, 0.0f)) + 1; }
+};
+
+// Heightfield drawn with quadtree LOD around the active camera, see Heightfield. Drawn with the entity's shaders
+// that have an INDIRECT variant.
+struct Terrain {
+  std::shared_ptr<Heightfield> Field;
+  float LodDistance = 2.0f;  // nodes split while the camera is closer than this many times their size
+
+  Terrain() {}
+  Terrain(const Terrain &other) : Field(other.Field), LodDistance(other.LodDistance) {}
+  Terrain(const std::shared_ptr<Heightfield> &field, float lodDistance = 2.0f) : Field(field), LodDistance(lodDistance) {}
 };
 
 }  // namespace Ham::Component
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+#include "Ham/Renderer/Buffer.h"
+#include "Ham/Scene/Component.h"
+#include "Ham/Util/JobSystem.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Ham {
+
+// A quadtree node picked for drawing this frame, bounds are in the terrain's local space
+struct TerrainPatch {
+  uint32_t Node;
+  math::vec3 BoundsMin;
+  math::vec3 BoundsMax;
+  DrawElementsIndirectCommand Command;
+};
+
+// Height grid drawn with chunked LOD. The grid is covered by a quadtree whose leaves are TileQuads * TileQuads quad
+// tiles, every node is drawn as the same tile size with its samples spread further apart, so a node has a quarter of
+// the detail of its children. A node only splits into all four children at once, so children are built together by
+// a JobSystem job and kept in a fixed number of four tile slots of one vertex buffer (least recently used ones are
+// evicted), which makes a whole terrain a single glMultiDrawElementsIndirect.
+// Neighbouring nodes differ by at most one depth, the finer side drops every other vertex along the shared edge
+// (one of 16 index buffer variants) so there are no cracks.
+class Heightfield {
+ public:
+  static constexpr uint32_t TileQuads = 32;
+  static constexpr uint32_t TileSamples = TileQuads + 1;  // along a side
+  static constexpr uint32_t TileVertices = TileSamples * TileSamples;
+  static constexpr uint32_t MaxPendingSplits = 8;
+
+  // width * height samples in row major order, spacing apart. Heights go along math::up(), rows along
+  // math::forward() and columns along math::right()
+  Heightfield(std::vector<float> heights, uint32_t width, uint32_t height, float spacing, uint32_t slotCount = 96);
+  ~Heightfield();
+
+  static std::shared_ptr<Heightfield> Generate(uint32_t width, uint32_t height, float spacing, const std::function<float(float, float)> &function);
+
+  // Render thread. Uploads finished nodes, picks the nodes to draw for a camera at cameraPosition (terrain local
+  // space) and requests the missing ones. Nodes split while the camera is closer than lodDistance times their size.
+  void Update(const math::vec3 &cameraPosition, float lodDistance);
+
+  const std::vector<TerrainPatch> &GetPatches() const { return m_Patches; }
+  uint32_t GetVertexBufferID() const { return m_Vertices.GetID(); }
+  uint32_t GetIndexBufferID() const { return m_Indices.GetID(); }
+
+  float GetSample(int x, int y) const;  // clamped to the grid
+  uint32_t GetWidth() const { return m_Width; }
+  uint32_t GetHeight() const { return m_Height; }
+  float GetSpacing() const { return m_Spacing; }
+  uint32_t GetMaxDepth() const { return m_MaxDepth; }
+
+  uint32_t GetResidentCount() const { return m_ResidentCount; }
+  uint32_t GetSlotCount() const { return m_SlotCount; }  // each holds the four children of a node
+  uint32_t GetPendingCount() const { return (uint32_t)m_Pending.size(); }
+  uint32_t GetUsedCount() const { return m_UsedCount; }
+
+ private:
+  enum class NodeState : uint8_t {
+    EMPTY,
+    PENDING,
+    RESIDENT,
+  };
+
+  struct Node {
+    uint32_t Depth, X, Y;
+    math::vec3 BoundsMin, BoundsMax;
+    NodeState State = NodeState::EMPTY;
+    int32_t Tile = -1;  // position in the vertex buffer, in tiles
+  };
+
+  struct PendingSplit {
+    uint32_t Parent;
+    std::vector<Component::VertexData> Vertices;  // the four children one after another
+    JobSystem::Counter Counter;
+  };
+
+  static uint32_t GetNodeIndex(uint32_t depth, uint32_t x, uint32_t y) { return ((1u << (2 * depth)) - 1) / 3 + y * (1u << depth) + x; }
+  static uint32_t GetChildIndex(uint32_t depth, uint32_t x, uint32_t y, uint32_t child) { return GetNodeIndex(depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1)); }
+  uint32_t GetTileCount() const { return 1u << m_MaxDepth; }  // leaf tiles along a side
+  uint32_t GetStep(uint32_t depth) const { return 1u << (m_MaxDepth - depth); }  // samples between node vertices
+
+  math::vec3 GetPosition(int x, int y) const;
+  void BuildVertices(const Node &node, std::vector<Component::VertexData> &vertices) const;
+  void BuildIndices();
+
+  void UploadFinished();
+  void RequestChildren(uint32_t parent);
+  int32_t AcquireSlot();
+
+  // per leaf tile depth of the node covering it, see Update
+  uint8_t &TileDepth(uint32_t x, uint32_t y) { return m_TileDepth[y * GetTileCount() + x]; }
+  void SetBlock(uint32_t depth, uint32_t x, uint32_t y, uint8_t value, bool raise);
+  void SelectByDistance(uint32_t depth, uint32_t x, uint32_t y, const math::vec3 &cameraPosition, float lodDistance);
+  void SelectResident(uint32_t depth, uint32_t x, uint32_t y);
+  bool Balance(bool raise);
+  void CollectPatches(uint32_t depth, uint32_t x, uint32_t y);
+
+ private:
+  std::vector<float> m_Heights;
+  uint32_t m_Width = 0;
+  uint32_t m_Height = 0;
+  float m_Spacing = 1.0f;
+  uint32_t m_MaxDepth = 0;
+
+  std::vector<Node> m_Nodes;
+  std::vector<uint8_t> m_TileDepth;
+  std::vector<TerrainPatch> m_Patches;
+  std::vector<std::unique_ptr<PendingSplit>> m_Pending;
+
+  uint32_t m_SlotCount = 0;
+  std::vector<uint32_t> m_SlotParents;  // whose children are in each slot, or -1. Slot 0 holds just the root
+  std::vector<uint64_t> m_SlotLastUsed;
+  uint32_t m_ResidentCount = 0;       // slots in use
+  uint32_t m_UsedCount = 0;           // of those, the ones split into this frame
+  uint32_t m_PreviousUsedCount = 0;
+  uint64_t m_Frame = 0;
+
+  VertexBuffer<Component::VertexData> m_Vertices;  // m_SlotCount * 4 * TileVertices
+  IndexBuffer m_Indices;                           // 16 stitching variants, see BuildIndices
+  uint32_t m_VariantOffsets[16] = {};
+  uint32_t m_VariantCounts[16] = {};
+};
+
+}  // namespace Ham
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Ham/Core/Math.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Ham {
+
+// std430 layout, must match particles.vert
+struct ParticleInstance {
+  float X, Y, Z;
+  float Age;  // 0 at birth, 1 when the particle dies
+};
+
+// Per emitter draw data, indexed by gl_DrawID in particles.vert
+struct ParticleEmitterData {
+  math::vec4 StartColor;
+  math::vec4 EndColor;
+  math::vec4 Size;  // x = start size, y = end size
+};
+
+// Particle state of one emitter in structure of arrays form, so the simulation kernel works on four particles at
+// a time. Every particle of a pool lives for the same time, which makes the pool a FIFO ring: the oldest particles
+// are always at the head, dying only moves the head and spawning appends at the tail. Plain CPU code, no GL context
+// is needed.
+class ParticlePool {
+ public:
+  ParticlePool() {}
+  ~ParticlePool() {}
+
+  // Keeps the youngest particles if the pool shrinks
+  void Reserve(uint32_t capacity);
+
+  // Call order per frame: Retire, Emit, then Simulate on disjoint ranges of [0, GetCount()) from any thread
+  void Retire(float deltaTime, float lifetime);
+  // Spawns rate * deltaTime particles at origin moving along direction, spread 0 is a ray and 1 about a hemisphere
+  uint32_t Emit(float deltaTime, float rate, const math::vec3 &origin, const math::vec3 &direction, float speed, float spread);
+  // Integrates particles [begin, end) counted from the oldest and writes them to out[0, end - begin)
+  void Simulate(uint32_t begin, uint32_t end, float deltaTime, const math::vec3 &gravity, float lifetime, ParticleInstance *out);
+
+  void Clear();
+
+  uint32_t GetCount() const { return m_Count; }
+  uint32_t GetCapacity() const { return (uint32_t)m_Age.size(); }
+
+ private:
+  uint32_t GetIndex(uint32_t particle) const { return (m_Head + particle) % GetCapacity(); }
+  void SimulateRange(uint32_t index, uint32_t count, float deltaTime, const math::vec3 &gravity, float invLifetime, ParticleInstance *out);
+
+ private:
+  std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+  std::vector<float> m_VelocityX, m_VelocityY, m_VelocityZ;
+  std::vector<float> m_Age;  // seconds
+
+  uint32_t m_Head = 0;  // oldest particle
+  uint32_t m_Count = 0;
+  float m_EmitRemainder = 0.0f;  // fraction of a particle carried over to the next frame
+};
+
+}  // namespace Ham
@@ -3,6 +3,8 @@
 
 #include "Ham/Scene/Component.h"
 #include "Ham/Renderer/FrameBuffer.h"
+#include "Ham/Renderer/PixelReadback.h"
+#include "Ham/Renderer/RenderCommand.h"
 
 namespace Ham {
 class Systems {
@@ -13,7 +15,15 @@ class Systems {
   static void UpdateNativeScripts(Scene &scene, TimeStep &deltaTime);
   static void UpdateNativeScriptsUI(Scene &scene, TimeStep &deltaTime);
   static void RenderScene(Application &app, Scene &scene, TimeStep &deltaTime);
-  static void RenderObjectPickerFrame(Application &app, Scene &scene, TimeStep &deltaTime);
-  static void HandleObjectPicker(Application &app, Scene &scene, FrameBuffer &frameBuffer, TimeStep &deltaTime, std::atomic_bool& clicked);
+  static void FlushMeshEdits(Application &app, Scene &scene);
+  static void UpdateOcclusion(Application &app, Scene &scene, const FrameData &frame);
+  static void UpdateLights(Application &app, Scene &scene, FrameData &frame);
+  static void RenderSceneIndirect(Application &app, Scene &scene, const FrameData &frame);
+  static void RenderTerrain(Application &app, Scene &scene, const FrameData &frame);
+  static void RenderParticles(Application &app, Scene &scene, const FrameData &frame, TimeStep &deltaTime);
+  static void RecordMesh(RenderCommandList &list, const Component::Mesh &mesh, const math::mat4 &model, const math::mat4 &normal, const Component::ResolvedShader &shader, int id);
+  static void ResolveShaders(Component::ShaderList &shaders, uint32_t state, bool indirect);
+  static uint32_t GetMeshState(const Component::Mesh &mesh);
+  static void HandleObjectPicker(Application &app, Scene &scene, FrameBuffer &frameBuffer, PixelReadback &readback, TimeStep &deltaTime, std::atomic_bool &clicked);
 };
 }  // namespace Ham
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Ham {
+
+// Small fixed pool of worker threads. The caller of Wait()/ParallelFor() helps out with queued jobs,
+// so it is fine to use from the render thread without oversubscribing.
+class JobSystem {
+ public:
+  struct Counter {
+    std::atomic_uint32_t Pending = 0;
+  };
+
+  static void Init(uint32_t threadCount = 0);  // 0 = hardware threads - 2 (main + render thread)
+  static void Shutdown();
+
+  static void Execute(const std::function<void()> &job, Counter &counter);
+  static void Wait(Counter &counter);
+
+  // Splits [0, count) into batches of at least minBatchSize and runs func(begin, end, batchIndex) on them,
+  // returns once every batch is done. Batch indices are dense, use GetBatchCount() to size per-batch outputs.
+  static void ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t, uint32_t)> &func);
+  static uint32_t GetBatchCount(uint32_t count, uint32_t minBatchSize);
+
+  static uint32_t GetThreadCount() { return (uint32_t)s_Threads.size(); }
+
+ private:
+  struct Job {
+    std::function<void()> Function;
+    Counter *Owner;
+  };
+
+  static bool RunPendingJob();
+  static void WorkerThread(uint32_t index);
+
+ private:
+  static std::vector<std::thread> s_Threads;
+  static std::deque<Job> s_Jobs;
+  static std::mutex s_Mutex;
+  static std::condition_variable s_Condition;
+  static bool s_Running;
+};
+
+}  // namespace Ham
@@ -6,7 +6,9 @@
 
 #include <string>
 #include <functional>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace Ham {
 struct FileListenerData;
@@ -16,6 +18,7 @@ class FileListener : public FW::FileWatchListener {
 
  private:
   std::unordered_map<std::string, FileListenerData> m_WatcherList;
+  std::vector<std::string> m_ChangedFiles;  // collected during Update, callbacks run after the watchers are done
   friend class FileWatcher;
 };
 
@@ -30,16 +33,20 @@ class FileWatcher {
     delete s_FileListener;
   }
 
+  // Callbacks run on the thread calling Update and may watch/unwatch files themselves.
+  // Watch and Unwatch can be called from any thread.
   static void Update();
-  static void Watch(std::string filePath, std::function<void()> OnFileChanged);
-  static void Unwatch(std::string filePath);
+  static uint32_t Watch(std::string filePath, std::function<void()> OnFileChanged);
+  static void Unwatch(std::string filePath, uint32_t id);
 
  private:
   static FileListener* s_FileListener;
+  static std::mutex s_Mutex;
+  static uint32_t s_NextID;
 };
 
 struct FileListenerData {
-  std::function<void()> OnFileChanged;
+  std::unordered_map<uint32_t, std::function<void()>> OnFileChanged;  // any number of listeners per file
   std::shared_ptr<FW::FileWatcher> fileWatcher;
 };
 
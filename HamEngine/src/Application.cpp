@@ -1,9 +1,12 @@
 #include "Ham/Core/Application.h"
 
 #include "Ham/Core/Log.h"
+#include "Ham/Debug/GpuProfiler.h"
+#include "Ham/Debug/RenderStats.h"
 #include "Ham/Editor/EditorLayer.h"
 #include "Ham/Input/Input.h"
 #include "Ham/Renderer/Shader.h"
+#include "Ham/Renderer/ShaderCompiler.h"
 #include "Ham/Renderer/ShaderLibrary.h"
 #include "Ham/Scene/Component.h"
 #include "Ham/Scene/Entity.h"
@@ -11,6 +14,7 @@
 #include "Ham/Scene/Systems.h"
 #include "Ham/Script/CameraController.h"
 #include "Ham/Util/GLFWExtra.h"
+#include "Ham/Util/JobSystem.h"
 #include "Ham/Util/Random.h"
 #include "Ham/Util/TimeStep.h"
 #include "Ham/Util/UUID.h"
@@ -19,7 +23,9 @@
 
 #include <imgui.h>
 
+#include <charconv>
 #include <ranges>
+#include <string_view>
 
 namespace Ham {
 Application *Application::s_Instance = nullptr;
@@ -28,10 +34,75 @@ Application::Application(const ApplicationSpecification &spec) : m_Specification
 {
   HAM_CORE_ASSERT(!s_Instance, "Application already exists!");
   s_Instance = this;
+  ParseCommandLine();
   m_Specification.DefaultWidth = m_Specification.Width;
   m_Specification.DefaultHeight = m_Specification.Height;
 }
 
+// Reads the value after args[i] into value. A missing, malformed or out of range value (or one below minimum) is
+// reported and the default is kept, a typo on the command line should not take the program down.
+template <typename T>
+static void ParseArgument(const ApplicationCommandLineArgs &args, int &i, T &value, T minimum)
+{
+  std::string flag = args[i];
+  if (i + 1 >= args.Count) {
+    HAM_CORE_WARN("Missing value after {0}, keeping {1}", flag, value);
+    return;
+  }
+
+  std::string_view text = args[++i];
+  T parsed{};
+  auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+  if (error != std::errc() || end != text.data() + text.size() || parsed < minimum) {
+    HAM_CORE_WARN("Invalid value '{0}' for {1}, keeping {2}", text, flag, value);
+    return;
+  }
+  value = parsed;
+}
+
+void Application::ParseCommandLine()
+{
+  auto &args = m_Specification.CommandLineArgs;
+  for (int i = 1; i < args.Count; i++) {
+    std::string arg = args[i];
+
+    if (arg == "--headless")
+      m_Specification.Headless = true;
+    else if (arg == "--frames")
+      ParseArgument(args, i, m_Specification.FrameLimit, 0u);
+    else if (arg == "--capture" && i + 1 < args.Count)
+      m_Specification.CapturePath = args[++i];
+    else if (arg == "--capture")
+      HAM_CORE_WARN("Missing path after --capture, nothing will be saved");
+    else if (arg == "--width")
+      ParseArgument(args, i, m_Specification.Width, 1);
+    else if (arg == "--height")
+      ParseArgument(args, i, m_Specification.Height, 1);
+    else if (arg == "--dynamic-resolution")
+      m_Specification.DynamicResolution = true;
+    else if (arg == "--target-fps")
+      ParseArgument(args, i, m_Specification.TargetFrameRate, 1.0f);
+    else
+      HAM_CORE_WARN("Ignoring command line argument {0}", arg);
+  }
+}
+
+void Application::FinishHeadlessRun(uint64_t frameCount, float seconds)
+{
+  HAM_CORE_INFO("Rendered {0} frames in {1:.3f}s ({2:.3f} ms/frame)", frameCount, seconds, frameCount > 0 ? seconds * 1000.0f / frameCount : 0.0f);
+  for (auto &zone : GpuProfiler::GetResults())
+    HAM_CORE_INFO("GPU {0:>{1}}{2}: {3:.3f} ms", "", zone.Depth * 2, zone.Name, zone.Average);
+
+  auto average = RenderStats::GetAverage();
+  for (uint32_t counter = 0; counter < (uint32_t)RenderCounter::COUNT; counter++)
+    HAM_CORE_INFO("{0}: {1}/frame", RenderStats::GetName((RenderCounter)counter), average[(RenderCounter)counter]);
+
+  if (!m_Specification.CapturePath.empty()) {
+    if (m_SceneFramebuffer.SaveToFile(m_Specification.CapturePath))
+      HAM_CORE_INFO("Saved frame to {0}", m_Specification.CapturePath);
+  }
+}
+
 Application::~Application()
 {
   // FIXME: App doesnt like this for some reason
@@ -41,6 +112,7 @@ Application::~Application()
   // and uncomment the following line
   // FileWatcher::Shutdown();
 
+  m_Scene.m_Registry.on_destroy<Component::Mesh>().disconnect<&Application::OnMeshDestroyed>(*this);
   s_Instance = nullptr;
 }
 
@@ -51,6 +123,8 @@ void Application::Init()
   FileWatcher::Init();
   m_Window.Init(this);
   Random::Init();
+  JobSystem::Init();
+  ShaderCompiler::Init(m_Window.GetLoaderContext());
   ShaderLibrary::Init();
   Input::Init();
 
@@ -83,11 +157,33 @@ void Application::Init()
   frameBufferSpec.Width = display.x;
   frameBufferSpec.Height = display.y;
   frameBufferSpec.Samples = 1;
-  frameBufferSpec.ClearColor = {1.0f, 1.0f, 1.0f, 1.0f};
-  frameBufferSpec.ColorAttachments = {TextureFormat::COLOR_RGBA8};
+  frameBufferSpec.ClearColor = m_Window.GetClearColor();
+  frameBufferSpec.ClearInteger = entt::to_integral(entt::entity(entt::null));
+  frameBufferSpec.ColorAttachments = {TextureFormat::COLOR_RGBA8, TextureFormat::COLOR_R32UI};
   frameBufferSpec.MinFilter = TextureFilter::NEAREST;
   frameBufferSpec.MagFilter = TextureFilter::NEAREST;
-  m_ObjectPickerFramebuffer.Init(frameBufferSpec);
+  m_SceneFramebuffer.Init(frameBufferSpec);
+  m_ObjectPickerReadback.Init(1, 1, sizeof(uint32_t));
+
+  m_GeometryBuffer.Init(Component::VertexData::GetLayout());
+  m_Scene.m_Registry.on_destroy<Component::Mesh>().connect<&Application::OnMeshDestroyed>(*this);
+
+  m_IndirectCommandBuffer.Create();
+  m_IndirectCommandBuffer.SetDrawMode(DrawMode::STREAM);
+  m_IndirectDrawDataBuffer.Create();
+  m_IndirectDrawDataBuffer.SetDrawMode(DrawMode::STREAM);
+
+  m_LightBuffer.Create();
+  m_LightBuffer.SetDrawMode(DrawMode::DYNAMIC);
+  m_LightClusterBuffer.Create();
+  m_LightClusterBuffer.SetDrawMode(DrawMode::DYNAMIC);
+  m_LightIndexBuffer.Create();
+  m_LightIndexBuffer.SetDrawMode(DrawMode::DYNAMIC);
+  m_ParticleBuffer.Create();
+  m_ParticleBuffer.SetDrawMode(DrawMode::STREAM);
+
+  m_StreamBuffer.Init(GL_SHADER_STORAGE_BUFFER, 1 << 20);
+  m_OcclusionCuller.Init();
 
   // *******
   // auto cameraEntity = m_Scene.CreateEntity("Camera");
@@ -112,6 +208,12 @@ void Application::Init()
   // HAM_CORE_INFO("Forward vector is: {0}", math::to_string(math::forward()));
 }
 
+// Releases the mesh's part of the geometry buffer right away instead of waiting for GeometryBuffer::EndFrame
+void Application::OnMeshDestroyed(entt::registry &registry, entt::entity entity)
+{
+  m_GeometryBuffer.Free(registry.get<Component::Mesh>(entity).GeometryHandle);
+}
+
 void Application::PushLayer(Layer *layer)
 {
   HAM_PROFILE_SCOPE();
@@ -203,6 +305,10 @@ void Application::RenderThread()
   // {0.2f, 0.16f, 0.13f, 1.0f} // brown (dark)
 
   m_imgui.Init(&m_Window);
+  GpuProfiler::Init();
+
+  m_DynamicResolution.SetTargetFrameTime(1000.0f / m_Specification.TargetFrameRate);
+  m_DynamicResolution.SetEnabled(m_Specification.DynamicResolution);
 
   {
     // pre-loop
@@ -217,6 +323,9 @@ void Application::RenderThread()
   m_Window.SetIsRunning(true);
   m_FramebufferResized = true;
 
+  uint64_t frameCount = 0;
+  auto runStart = std::chrono::high_resolution_clock::now();
+
   while (m_Window.IsRunning()) {
     {
       HAM_PROFILE_SCOPE_NAMED("Render Poll Events");
@@ -236,6 +345,13 @@ void Application::RenderThread()
     if (glfwGetCurrentContext() != m_Window.GetWindowHandle())
       m_Window.SetContextCurrent();
 
+    {
+      HAM_PROFILE_SCOPE_NAMED("Stream Buffer Wait");
+      m_StreamBuffer.BeginFrame();
+    }
+    GpuProfiler::BeginFrame();
+    auto frameStart = std::chrono::high_resolution_clock::now();
+
     if (m_FramebufferResized) {
       HAM_PROFILE_SCOPE_NAMED("Framebuffer Resized");
       display = m_Window.GetFramebufferSize();
@@ -244,7 +360,8 @@ void Application::RenderThread()
       if (m_Scene.GetActiveCamera()) {
         m_Scene.GetActiveCamera().GetComponent<Component::Camera>().Update((float)display.x, (float)display.y);
       }
-      m_ObjectPickerFramebuffer.Resize(display.x, display.y);
+      auto renderSize = m_DynamicResolution.GetRenderSize(display.x, display.y);
+      m_SceneFramebuffer.Resize(renderSize.x, renderSize.y);
     }
 
     float time = GetTime();
@@ -270,34 +387,92 @@ void Application::RenderThread()
     }
 
     {
-      m_Window.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-      Systems::RenderScene(*this, m_Scene, timestep);
-      Systems::HandleObjectPicker(*this, m_Scene, m_ObjectPickerFramebuffer, timestep, m_MouseLeftClickedThisFrame);
+      HAM_PROFILE_SCOPE_NAMED("Render Graph");
+      m_SceneFramebuffer.SetClearColor(m_Window.GetClearColor());
+
+      // nothing reads the scene depth after the frame, only color and entity ids
+      m_RenderGraph.Reset();
+      auto scene = m_RenderGraph.Import("Scene", &m_SceneFramebuffer, AttachmentType::DEPTH | AttachmentType::STENCIL);
+      auto backbuffer = m_RenderGraph.Import("Backbuffer", nullptr);
+
+      // color and entity ids are written in the same pass, the color is then copied to the window
+      m_RenderGraph.AddPass(
+          "Scene", [&](RenderGraphBuilder &builder) { builder.Write(scene, AttachmentType::COLOR | AttachmentType::DEPTH | AttachmentType::STENCIL); },
+          [&](RenderGraph &) { Systems::RenderScene(*this, m_Scene, timestep); });
+
+      if (!IsHeadless()) {
+        m_RenderGraph.AddPass(
+            "Blit", [&](RenderGraphBuilder &builder) {
+              builder.Read(scene);
+              builder.Write(backbuffer);
+            },
+            [&](RenderGraph &) {
+              m_SceneFramebuffer.Blit(0, 0, display.x, display.y);
+              glViewport(0, 0, display.x, display.y);  // the scene pass left it at the render size
+            });
+      }
+
+      m_RenderGraph.AddPass(
+          "Object Picker", [&](RenderGraphBuilder &builder) {
+            builder.Read(scene);
+            builder.SideEffect();
+          },
+          [&](RenderGraph &) { Systems::HandleObjectPicker(*this, m_Scene, m_SceneFramebuffer, m_ObjectPickerReadback, timestep, m_MouseLeftClickedThisFrame); });
+
+      m_RenderGraph.Compile();
+      m_RenderGraph.Execute(m_RenderTargetPool);
     }
 
     {
       HAM_PROFILE_SCOPE_NAMED("ImGui Render");
+      HAM_PROFILE_GPU_SCOPE("ImGui");
       m_imgui.Render();
     }
 
+    // before the viewports, they switch contexts and the queries belong to this one
+    GpuProfiler::EndFrame();
+
     {
       HAM_PROFILE_SCOPE_NAMED("ImGui Update Windows");
       m_imgui.UpdateWindows();
     }
 
+    m_StreamBuffer.EndFrame();
+    m_RenderTargetPool.EndFrame();
+
+    // measured before presenting, waiting for vsync isn't work
+    float cpuTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+    if (m_DynamicResolution.Update(cpuTime, GpuProfiler::GetFrameTime()))
+      m_FramebufferResized = true;
+
     {
       HAM_PROFILE_SCOPE_NAMED("Present");
-      m_Window.Present();
+      if (IsHeadless())
+        glFinish();  // nothing to present, but frame times should include the GPU work
+      else
+        m_Window.Present();
     }
 
-    for (auto shader : Shader::s_Shaders) {
-      shader->PerformReload();
-    }
+    // also compiles variants first requested this frame, headless runs wait for them so captures don't depend on timing
+    Shader::PerformReloads(IsHeadless());
 
     Input::EndFrame();
+    RenderStats::EndFrame();
     HAM_PROFILE_FRAME("Render Frame");
+
+    frameCount++;
+    if (GetSpecification().FrameLimit > 0 && frameCount >= GetSpecification().FrameLimit)
+      m_Window.SetIsRunning(false);
   }
 
+  if (IsHeadless())
+    FinishHeadlessRun(frameCount, std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - runStart).count());
+
+  // the context is still current here
+  m_RenderTargetPool.Clear();
+  VertexArray::ClearShared();
+  GpuProfiler::Shutdown();
+
   // make sure the main thread knows we're done
   m_Window.SetIsRunning(false);
 
@@ -414,5 +589,8 @@ void Application::Run()
 
   if (m_RenderThread.joinable())
     m_RenderThread.join();
+
+  ShaderCompiler::Shutdown();
+  JobSystem::Shutdown();
 }
 }  // namespace Ham
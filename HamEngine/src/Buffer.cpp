@@ -0,0 +1,76 @@
+#include "Ham/Renderer/Buffer.h"
+
+#include "Ham/Core/Base.h"
+
+namespace Ham {
+
+std::vector<std::shared_ptr<VertexArray>> VertexArray::s_Shared;
+
+static bool IsIntegerType(uint32_t type)
+{
+  switch (type) {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void VertexArray::Create(const VertexLayout &layout)
+{
+  HAM_CORE_ASSERT(m_VertexArrayID == 0, "VertexArray already created!");
+  m_Layout = layout;
+  glCreateVertexArrays(1, &m_VertexArrayID);
+
+  // everything reads from binding 0, SetBuffers attaches the vertex buffer there
+  auto &attributes = layout.GetAttributes();
+  for (uint32_t i = 0; i < attributes.size(); i++) {
+    auto &attribute = attributes[i];
+    glEnableVertexArrayAttrib(m_VertexArrayID, i);
+    if (IsIntegerType(attribute.Type) && !attribute.Normalized)
+      glVertexArrayAttribIFormat(m_VertexArrayID, i, attribute.Components, attribute.Type, attribute.Offset);
+    else
+      glVertexArrayAttribFormat(m_VertexArrayID, i, attribute.Components, attribute.Type, attribute.Normalized ? GL_TRUE : GL_FALSE, attribute.Offset);
+    glVertexArrayAttribBinding(m_VertexArrayID, i, 0);
+  }
+}
+
+void VertexArray::Destroy()
+{
+  if (m_VertexArrayID == 0)
+    return;
+  glDeleteVertexArrays(1, &m_VertexArrayID);
+  m_VertexArrayID = 0;
+}
+
+void VertexArray::SetBuffers(uint32_t vertexBuffer, uint32_t indexBuffer, size_t vertexOffset) const
+{
+  glVertexArrayVertexBuffer(m_VertexArrayID, 0, vertexBuffer, (GLintptr)vertexOffset, m_Layout.GetStride());
+  glVertexArrayElementBuffer(m_VertexArrayID, indexBuffer);
+}
+
+std::shared_ptr<VertexArray> VertexArray::Get(const VertexLayout &layout)
+{
+  for (auto &vertexArray : s_Shared)
+    if (vertexArray->GetLayout() == layout)
+      return vertexArray;
+
+  auto vertexArray = std::make_shared<VertexArray>();
+  vertexArray->Create(layout);
+  s_Shared.push_back(vertexArray);
+  return vertexArray;
+}
+
+void VertexArray::ClearShared()
+{
+  for (auto &vertexArray : s_Shared)
+    vertexArray->Destroy();
+  s_Shared.clear();
+}
+
+}  // namespace Ham
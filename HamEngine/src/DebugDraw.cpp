@@ -0,0 +1,228 @@
+#include "Ham/Debug/DebugDraw.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+#include "Ham/Debug/RenderStats.h"
+#include "Ham/Renderer/RingBuffer.h"
+#include "Ham/Renderer/ShaderLibrary.h"
+
+#include <glad/gl.h>
+
+#include <cmath>
+#include <cstddef>
+
+namespace Ham {
+
+std::mutex DebugDraw::s_Mutex;
+std::vector<std::unique_ptr<DebugDraw::ThreadLines>> DebugDraw::s_Threads;
+std::vector<DebugVertex> DebugDraw::s_Merged;
+std::shared_ptr<VertexArray> DebugDraw::s_VertexArray;
+VertexBuffer<DebugVertex> DebugDraw::s_FallbackBuffer;
+uint32_t DebugDraw::s_LastLineCount = 0;
+uint32_t DebugDraw::s_PipelineShader = 0;
+PipelineID DebugDraw::s_Pipelines[LAYER_COUNT] = {};
+
+DebugDraw::ThreadLines &DebugDraw::GetThreadLines()
+{
+  // registered once per thread and never removed, the job system threads live as long as the application
+  static thread_local ThreadLines *lines = nullptr;
+  if (lines == nullptr) {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    lines = s_Threads.emplace_back(std::make_unique<ThreadLines>()).get();
+  }
+  return *lines;
+}
+
+uint32_t DebugDraw::PackColor(const math::vec4 &color)
+{
+  uint32_t packed = 0;
+  for (int i = 0; i < 4; i++)
+    packed |= (uint32_t)(math::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f) << (i * 8);
+  return packed;
+}
+
+void DebugDraw::Line(const math::vec3 &from, const math::vec3 &to, const math::vec4 &color, bool overlay)
+{
+  auto &lines = GetThreadLines();
+  uint32_t packed = PackColor(color);
+
+  std::lock_guard<std::mutex> lock(lines.Mutex);
+  auto &vertices = lines.Vertices[overlay ? OVERLAY : DEPTH_TESTED];
+  vertices.push_back({from, packed});
+  vertices.push_back({to, packed});
+}
+
+void DebugDraw::Box(const math::vec3 &min, const math::vec3 &max, const math::vec4 &color, bool overlay)
+{
+  math::vec3 corners[8];
+  for (int i = 0; i < 8; i++)
+    corners[i] = math::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+  AddCorners(corners, PackColor(color), overlay);
+}
+
+void DebugDraw::Box(const math::vec3 &min, const math::vec3 &max, const math::mat4 &transform, const math::vec4 &color, bool overlay)
+{
+  math::vec3 corners[8];
+  for (int i = 0; i < 8; i++) {
+    math::vec4 corner = transform * math::vec4((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f);
+    corners[i] = corner.xyz;
+  }
+  AddCorners(corners, PackColor(color), overlay);
+}
+
+void DebugDraw::Circle(const math::vec3 &center, const math::vec3 &normal, float radius, const math::vec4 &color, bool overlay, uint32_t segments)
+{
+  math::vec3 axis = math::normalize(normal);
+  math::vec3 tangent = math::normalize(math::cross(axis, std::abs(axis.y) < 0.99f ? math::vec3(0.0f, 1.0f, 0.0f) : math::vec3(1.0f, 0.0f, 0.0f)));
+  math::vec3 bitangent = math::cross(axis, tangent);
+
+  auto &lines = GetThreadLines();
+  uint32_t packed = PackColor(color);
+
+  std::lock_guard<std::mutex> lock(lines.Mutex);
+  auto &vertices = lines.Vertices[overlay ? OVERLAY : DEPTH_TESTED];
+  math::vec3 previous = center + tangent * radius;
+  for (uint32_t i = 1; i <= segments; i++) {
+    float angle = 2.0f * math::pi<float> * (float)i / (float)segments;
+    math::vec3 point = center + (tangent * std::cos(angle) + bitangent * std::sin(angle)) * radius;
+    vertices.push_back({previous, packed});
+    vertices.push_back({point, packed});
+    previous = point;
+  }
+}
+
+void DebugDraw::Sphere(const math::vec3 &center, float radius, const math::vec4 &color, bool overlay, uint32_t segments)
+{
+  Circle(center, math::vec3(1.0f, 0.0f, 0.0f), radius, color, overlay, segments);
+  Circle(center, math::vec3(0.0f, 1.0f, 0.0f), radius, color, overlay, segments);
+  Circle(center, math::vec3(0.0f, 0.0f, 1.0f), radius, color, overlay, segments);
+}
+
+void DebugDraw::Frustum(const math::mat4 &viewProjection, const math::vec4 &color, bool overlay)
+{
+  // corners of the NDC cube back in world space
+  math::mat4 inverse = math::inverse(viewProjection);
+  math::vec3 corners[8];
+  for (int i = 0; i < 8; i++) {
+    math::vec4 corner = inverse * math::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+    corners[i] = corner.xyz / corner.w;
+  }
+  AddCorners(corners, PackColor(color), overlay);
+}
+
+void DebugDraw::Axes(const math::mat4 &transform, float size, bool overlay)
+{
+  math::vec4 origin = transform * math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  for (int axis = 0; axis < 3; axis++) {
+    math::vec4 direction(0.0f, 0.0f, 0.0f, 1.0f);
+    direction[axis] = size;
+    math::vec4 color(0.0f, 0.0f, 0.0f, 1.0f);
+    color[axis] = 1.0f;
+
+    math::vec4 end = transform * direction;
+    Line(origin.xyz, end.xyz, color, overlay);
+  }
+}
+
+// corner i has bit 0 set for max x, bit 1 for max y and bit 2 for max z
+void DebugDraw::AddCorners(const math::vec3 (&corners)[8], uint32_t color, bool overlay)
+{
+  static constexpr int edges[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+  auto &lines = GetThreadLines();
+  std::lock_guard<std::mutex> lock(lines.Mutex);
+  auto &vertices = lines.Vertices[overlay ? OVERLAY : DEPTH_TESTED];
+  for (auto &edge : edges) {
+    vertices.push_back({corners[edge[0]], color});
+    vertices.push_back({corners[edge[1]], color});
+  }
+}
+
+void DebugDraw::Render(RingBuffer &stream, const math::mat4 &viewProjection)
+{
+  HAM_PROFILE_SCOPE();
+
+  // depth tested lines first, then the overlay, so each layer is one contiguous range
+  uint32_t counts[LAYER_COUNT] = {};
+  s_Merged.clear();
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    for (uint32_t layer = 0; layer < LAYER_COUNT; layer++) {
+      for (auto &thread : s_Threads) {
+        std::lock_guard<std::mutex> threadLock(thread->Mutex);
+        auto &vertices = thread->Vertices[layer];
+        s_Merged.insert(s_Merged.end(), vertices.begin(), vertices.end());
+        counts[layer] += (uint32_t)vertices.size();
+        vertices.clear();
+      }
+    }
+  }
+
+  s_LastLineCount = (uint32_t)s_Merged.size() / 2;
+  if (s_Merged.empty())
+    return;
+
+  auto shader = ShaderLibrary::Get("debug-lines");
+  if (shader == nullptr || !shader->IsReady())
+    return;
+
+  if (s_VertexArray == nullptr)
+    s_VertexArray = VertexArray::Get(VertexLayout(sizeof(DebugVertex)).Add(offsetof(DebugVertex, Position), 3).Add(offsetof(DebugVertex, Color), 4, GL_UNSIGNED_BYTE, true));
+
+  uint32_t buffer;
+  size_t offset = 0;
+  if (stream.Write(s_Merged, offset)) {
+    buffer = stream.GetID();
+  }
+  else {
+    if (!s_FallbackBuffer.IsInitialized()) {
+      s_FallbackBuffer.Create();
+      s_FallbackBuffer.SetDrawMode(DrawMode::STREAM);
+    }
+    s_FallbackBuffer.SetData(s_Merged);
+    buffer = s_FallbackBuffer.GetID();
+    offset = 0;
+  }
+
+  // lines are blended over the scene and leave depth and entity ids alone
+  if (s_PipelineShader != shader->GetHandle()) {
+    PipelineState state;
+    state.Program = shader.get();
+    state.DepthWrite = false;
+    state.WriteEntityID = false;
+    state.Blend = BlendMode::ALPHA;
+    for (uint32_t layer = 0; layer < LAYER_COUNT; layer++) {
+      state.DepthTest = layer == DEPTH_TESTED;
+      s_Pipelines[layer] = PipelineCache::Get(state);
+    }
+    s_PipelineShader = shader->GetHandle();
+  }
+
+  PipelineCache::Bind(s_Pipelines[DEPTH_TESTED]);
+  shader->SetUniformMat4f("uViewProjection", viewProjection);
+  s_VertexArray->Bind();
+  s_VertexArray->SetBuffers(buffer, 0, offset);
+
+  uint32_t first = 0;
+  for (uint32_t layer = 0; layer < LAYER_COUNT; layer++) {
+    if (counts[layer] == 0)
+      continue;
+
+    PipelineCache::Bind(s_Pipelines[layer]);
+    glDrawArrays(GL_LINES, first, counts[layer]);
+    RenderStats::Add(RenderCounter::DRAW_CALLS);
+    first += counts[layer];
+  }
+}
+
+void DebugDraw::Clear()
+{
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  for (auto &thread : s_Threads) {
+    std::lock_guard<std::mutex> threadLock(thread->Mutex);
+    for (auto &vertices : thread->Vertices)
+      vertices.clear();
+  }
+}
+
+}  // namespace Ham
@@ -0,0 +1,127 @@
+#include "Ham/Renderer/DepthSorter.h"
+
+#include "Ham/Debug/Profiler.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAM_DEPTH_SORTER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Ham {
+
+void DepthSorter::Clear()
+{
+  m_X.clear();
+  m_Y.clear();
+  m_Z.clear();
+  m_Items.clear();
+}
+
+void DepthSorter::Add(const math::vec3 &center, uint32_t item)
+{
+  m_X.push_back(center.x);
+  m_Y.push_back(center.y);
+  m_Z.push_back(center.z);
+  m_Items.push_back(item);
+}
+
+const std::vector<uint32_t> &DepthSorter::Sort(const math::mat4 &view)
+{
+  HAM_PROFILE_SCOPE();
+
+  uint32_t count = GetCount();
+  ComputeKeys(view);
+
+  m_Sorted = m_Items;
+  m_KeysScratch.resize(count);
+  m_ItemsScratch.resize(count);
+  RadixSort(m_Keys.data(), m_Sorted.data(), m_KeysScratch.data(), m_ItemsScratch.data(), count);
+  return m_Sorted;
+}
+
+uint32_t DepthSorter::ToSortableKey(float value)
+{
+  // positive floats already compare like their bits, negative ones compare reversed
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t mask = (uint32_t)((int32_t)bits >> 31) | 0x80000000u;
+  return bits ^ mask;
+}
+
+// The camera looks down -z in view space, so ascending view z is farthest first
+void DepthSorter::ComputeKeys(const math::mat4 &view)
+{
+  uint32_t count = GetCount();
+  m_Keys.resize(count);
+
+  float rx = view(2, 0), ry = view(2, 1), rz = view(2, 2), rw = view(2, 3);
+  const float *x = m_X.data(), *y = m_Y.data(), *z = m_Z.data();
+  uint32_t *keys = m_Keys.data();
+
+  uint32_t i = 0;
+#ifdef HAM_DEPTH_SORTER_SSE
+  __m128 vx = _mm_set1_ps(rx), vy = _mm_set1_ps(ry), vz = _mm_set1_ps(rz), vw = _mm_set1_ps(rw);
+  __m128i sign = _mm_set1_epi32((int)0x80000000u);
+  for (; i + 4 <= count; i += 4) {
+    __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(x + i), vx), _mm_mul_ps(_mm_loadu_ps(y + i), vy)), _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(z + i), vz), vw));
+    __m128i bits = _mm_castps_si128(depth);
+    __m128i mask = _mm_or_si128(_mm_srai_epi32(bits, 31), sign);
+    _mm_storeu_si128((__m128i *)(keys + i), _mm_xor_si128(bits, mask));
+  }
+#endif
+
+  for (; i < count; i++)
+    keys[i] = ToSortableKey((x[i] * rx + y[i] * ry) + (z[i] * rz + rw));
+}
+
+void DepthSorter::RadixSort(uint32_t *keys, uint32_t *values, uint32_t *keysScratch, uint32_t *valuesScratch, uint32_t count)
+{
+  if (count < 2)
+    return;
+
+  // all four histograms in one read of the keys
+  uint32_t histograms[4][256] = {};
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t key = keys[i];
+    histograms[0][key & 0xFF]++;
+    histograms[1][(key >> 8) & 0xFF]++;
+    histograms[2][(key >> 16) & 0xFF]++;
+    histograms[3][key >> 24]++;
+  }
+
+  uint32_t *sourceKeys = keys, *sourceValues = values;
+  uint32_t *targetKeys = keysScratch, *targetValues = valuesScratch;
+  for (uint32_t pass = 0; pass < 4; pass++) {
+    uint32_t shift = pass * 8;
+    auto &histogram = histograms[pass];
+    if (histogram[(sourceKeys[0] >> shift) & 0xFF] == count)
+      continue;
+
+    uint32_t offsets[256];
+    uint32_t sum = 0;
+    for (uint32_t digit = 0; digit < 256; digit++) {
+      offsets[digit] = sum;
+      sum += histogram[digit];
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t key = sourceKeys[i];
+      uint32_t target = offsets[(key >> shift) & 0xFF]++;
+      targetKeys[target] = key;
+      targetValues[target] = sourceValues[i];
+    }
+
+    std::swap(sourceKeys, targetKeys);
+    std::swap(sourceValues, targetValues);
+  }
+
+  if (sourceKeys != keys) {
+    memcpy(keys, sourceKeys, count * sizeof(uint32_t));
+    memcpy(values, sourceValues, count * sizeof(uint32_t));
+  }
+}
+
+}  // namespace Ham
@@ -0,0 +1,77 @@
+#include "Ham/Renderer/DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Ham {
+
+void DynamicResolution::SetEnabled(bool enabled)
+{
+  m_Enabled = enabled;
+  m_Scale = m_MaxScale;
+  m_HeadroomFrames = 0;
+  m_CooldownFrames = 0;
+}
+
+void DynamicResolution::SetScaleRange(float minScale, float maxScale)
+{
+  m_MinScale = std::clamp(minScale, ScaleStep, 1.0f);
+  m_MaxScale = std::clamp(maxScale, m_MinScale, 1.0f);
+  m_Scale = std::clamp(m_Scale, m_MinScale, m_MaxScale);
+}
+
+bool DynamicResolution::Update(float cpuMilliseconds, float gpuMilliseconds)
+{
+  // smoothed for display and for scaling up, spikes are reacted to with the raw times
+  m_CpuTime = m_CpuTime == 0.0f ? cpuMilliseconds : m_CpuTime + (cpuMilliseconds - m_CpuTime) * 0.1f;
+  m_GpuTime = m_GpuTime == 0.0f ? gpuMilliseconds : m_GpuTime + (gpuMilliseconds - m_GpuTime) * 0.1f;
+
+  if (!m_Enabled)
+    return false;
+
+  if (m_CooldownFrames > 0) {
+    m_CooldownFrames--;
+    return false;
+  }
+
+  // aim below the target so there is room for the next spike
+  float budget = m_TargetFrameTime * 0.9f;
+  bool gpuBound = gpuMilliseconds <= 0.0f || gpuMilliseconds >= cpuMilliseconds;
+  float frameTime = std::max(cpuMilliseconds, gpuMilliseconds);
+  float smoothedFrameTime = std::max(m_CpuTime, m_GpuTime);
+
+  float scale = m_Scale;
+  if (frameTime > m_TargetFrameTime && gpuBound) {
+    // pixel cost grows with the square of the scale
+    scale = std::floor(m_Scale * std::sqrt(budget / frameTime) / ScaleStep) * ScaleStep;
+    m_HeadroomFrames = 0;
+  }
+  else if (smoothedFrameTime < budget * 0.8f) {
+    if (++m_HeadroomFrames >= IncreaseDelay) {
+      scale = m_Scale + ScaleStep;
+      m_HeadroomFrames = 0;
+    }
+  }
+  else {
+    m_HeadroomFrames = 0;
+  }
+
+  scale = std::clamp(scale, m_MinScale, m_MaxScale);
+  if (std::abs(scale - m_Scale) < ScaleStep * 0.5f)
+    return false;
+
+  m_Scale = scale;
+  m_CooldownFrames = Cooldown;
+  return true;
+}
+
+math::uvec2 DynamicResolution::GetRenderSize(uint32_t width, uint32_t height) const
+{
+  if (width == 0 || height == 0)  // minimized, keep it that way so the target isn't reallocated
+    return {0, 0};
+
+  float scale = GetScale();
+  return {std::max(1u, (uint32_t)(width * scale + 0.5f)), std::max(1u, (uint32_t)(height * scale + 0.5f))};
+}
+
+}  // namespace Ham
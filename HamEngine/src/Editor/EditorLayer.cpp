@@ -1,11 +1,14 @@
 #include "Ham/Editor/EditorLayer.h"
 
 #include "Ham/Core/Math.h"
+#include "Ham/Debug/DebugDraw.h"
+#include "Ham/Debug/GpuProfiler.h"
+#include "Ham/Debug/RenderStats.h"
 #include "Ham/Script/CameraController.h"
 #include "Ham/Util/ImGuiExtra.h"
 
 namespace Ham {
-EditorLayer::EditorLayer(Application *app) : Layer("EditorLayer"), m_App(app), m_Scene(m_App->GetScene()), m_ObjectPickerFramebuffer(m_App->GetObjectPickerFramebuffer()) {}
+EditorLayer::EditorLayer(Application *app) : Layer("EditorLayer"), m_App(app), m_Scene(m_App->GetScene()), m_SceneFramebuffer(m_App->GetSceneFramebuffer()) {}
 
 EditorLayer::~EditorLayer() {}
 
@@ -204,6 +207,45 @@ void EditorLayer::OnUIRender(TimeStep deltaTime)
     static auto vsync = m_App->IsVSync();
     if (ImGui::Checkbox("VSync", &vsync))
       m_App->SetVSync(vsync);
+    bool multiDrawIndirect = m_App->GetRenderMode() == RENDER_MODE_MULTI_DRAW_INDIRECT;
+    if (ImGui::Checkbox("Multi-Draw Indirect", &multiDrawIndirect))
+      m_App->SetRenderMode(multiDrawIndirect ? RENDER_MODE_MULTI_DRAW_INDIRECT : RENDER_MODE_DIRECT);
+
+    auto &streamBuffer = m_App->GetStreamBuffer();
+    ImGui::Text("Stream Buffer: %zu / %zu KB", streamBuffer.GetFrameUsed() / 1024, streamBuffer.GetFrameSize() / 1024);
+    ImGui::Text("Fence Wait: %.3f ms (max %.3f ms, %llu stalls)", streamBuffer.GetLastWaitTime(), streamBuffer.GetMaxWaitTime(), (unsigned long long)streamBuffer.GetStallCount());
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Reset"))
+      streamBuffer.ResetWaitStats();
+
+    auto &occlusionCuller = m_App->GetOcclusionCuller();
+    bool occlusionCulling = occlusionCuller.IsEnabled();
+    if (ImGui::Checkbox("Occlusion Culling", &occlusionCulling))
+      occlusionCuller.SetEnabled(occlusionCulling);
+    ImGui::Text("Occluder Triangles: %zu, Culled: %u / %u", occlusionCuller.GetOccluderTriangleCount(), occlusionCuller.GetCulledCount(), occlusionCuller.GetTestedCount());
+
+    auto &dynamicResolution = m_App->GetDynamicResolution();
+    bool dynamicResolutionEnabled = dynamicResolution.IsEnabled();
+    if (ImGui::Checkbox("Dynamic Resolution", &dynamicResolutionEnabled)) {
+      dynamicResolution.SetEnabled(dynamicResolutionEnabled);
+      m_App->TriggerCameraUpdate();
+    }
+    float targetFrameRate = 1000.0f / dynamicResolution.GetTargetFrameTime();
+    if (ImGui::DragFloat("Target FPS", &targetFrameRate, 1.0f, 10.0f, 240.0f))
+      dynamicResolution.SetTargetFrameTime(1000.0f / targetFrameRate);
+    float minScale = dynamicResolution.GetMinScale();
+    if (ImGui::SliderFloat("Min Scale", &minScale, DynamicResolution::ScaleStep, 1.0f)) {
+      dynamicResolution.SetScaleRange(minScale, dynamicResolution.GetMaxScale());
+      m_App->TriggerCameraUpdate();
+    }
+    ImGui::Text("Render Scale: %.2f (CPU %.2f ms, GPU %.2f ms)", dynamicResolution.GetScale(), dynamicResolution.GetCpuTime(), dynamicResolution.GetGpuTime());
+
+    auto &renderTargets = m_App->GetRenderTargetPool();
+    ImGui::Text("Scene Target: %ux%u (allocated %ux%u)", m_SceneFramebuffer.GetWidth(), m_SceneFramebuffer.GetHeight(), m_SceneFramebuffer.GetAllocatedWidth(), m_SceneFramebuffer.GetAllocatedHeight());
+    ImGui::Text("Render Target Pool: %u targets, %u allocations", renderTargets.GetTargetCount(), renderTargets.GetAllocationCount());
+
+    auto &renderGraph = m_App->GetRenderGraph();
+    ImGui::Text("Render Graph: %u passes (%u culled), %u transients in %u targets", renderGraph.GetPassCount(), renderGraph.GetCulledPassCount(), renderGraph.GetTransientCount(), renderGraph.GetPhysicalTargetCount());
 
     if (Input::IsKeyDown(KeyCode::LEFT_CONTROL))
       useSnap = true;
@@ -270,20 +312,81 @@ void EditorLayer::OnUIRender(TimeStep deltaTime)
 
   {
     if (ImGui::CollapsingHeader("Object Picker")) {
-      auto display = m_App->GetWindow().GetFramebufferSize();
-      std::vector<unsigned char> value = m_ObjectPickerFramebuffer.ReadPixels((int)Input::GetMousePosition().x, display.y - (int)Input::GetMousePosition().y, 1, 1);
-      uint32_t r = value[0];
-      uint32_t g = value[1];
-      uint32_t b = value[2];
-      uint32_t a = value[3];
-      uint32_t id = r + (g << 8) + (b << 16) + (a << 24);  // must be uint, dont change to int
-
-      auto image = m_ObjectPickerFramebuffer.GetColorAttachmentID(0);
-      auto windowWidth = ImGui::GetWindowSize().x;
-      auto windowHeight = windowWidth * ((float)display.y / (float)display.x);
-      ImGui::Image((void *)(intptr_t)image, {windowWidth, windowHeight}, ImVec2(0, 1), ImVec2(1, 0));
-      ImGui::Text("R: %d, G: %d, B: %d, A: %d", r, g, b, a);
-      ImGui::Text("ID: %d", id);
+      auto hovered = m_Scene.GetHoveredEntity();
+      if (hovered)
+        ImGui::Text("Hovered: %s (%u)", hovered.GetComponent<Component::Tag>().Name.c_str(), (uint32_t)entt::to_integral(hovered.GetHandle()));
+      else
+        ImGui::Text("Hovered: None");
+    }
+  }
+
+  if (ImGui::CollapsingHeader("GPU Timings")) {
+    if (!GpuProfiler::IsEnabled())
+      ImGui::Text("Timer queries not supported");
+
+    // results lag a few frames behind, see GpuProfiler
+    for (auto &zone : GpuProfiler::GetResults()) {
+      ImGui::SetCursorPosX(ImGui::GetCursorPosX() + zone.Depth * 12.0f);
+      ImGui::Text("%s: %.3f ms (%.3f ms)", zone.Name.c_str(), zone.Average, zone.Milliseconds);
+    }
+    ImGui::Text("Dropped Frames: %u", GpuProfiler::GetDroppedFrameCount());
+  }
+
+  if (ImGui::CollapsingHeader("Render Stats")) {
+    static RenderCounter plotted = RenderCounter::DRAW_CALLS;
+    static std::vector<float> history;
+
+    // last complete frame, average and peak over the history
+    auto &last = RenderStats::GetLastFrame();
+    auto average = RenderStats::GetAverage();
+    auto max = RenderStats::GetMax();
+    for (uint32_t i = 0; i < (uint32_t)RenderCounter::COUNT; i++) {
+      auto counter = (RenderCounter)i;
+      auto label = fmt::format("{0}: {1} (avg {2}, max {3})", RenderStats::GetName(counter), last[counter], average[counter], max[counter]);
+      if (ImGui::Selectable(label.c_str(), plotted == counter))
+        plotted = counter;
+    }
+
+    RenderStats::GetHistory(plotted, history);
+    ImGui::PlotLines("##RenderStatsHistory", history.data(), (int)history.size(), 0, RenderStats::GetName(plotted), 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+  }
+
+  static bool showMeshBounds = false;
+  static bool showLightRadii = false;
+  static bool showCameraFrusta = false;
+  static bool debugDrawOnTop = false;
+  if (ImGui::CollapsingHeader("Debug Draw")) {
+    ImGui::Checkbox("Mesh Bounds", &showMeshBounds);
+    ImGui::Checkbox("Light Radii", &showLightRadii);
+    ImGui::Checkbox("Camera Frusta", &showCameraFrusta);
+    ImGui::Checkbox("Draw On Top", &debugDrawOnTop);
+    ImGui::Text("Lines: %u", DebugDraw::GetLastLineCount());
+  }
+
+  if (showMeshBounds) {
+    auto view = m_Scene.GetRegistry()->view<Component::Mesh, Component::Transform>();
+    for (auto &entity : view) {
+      auto &mesh = view.get<Component::Mesh>(entity);
+      DebugDraw::Box(mesh.BoundsMin, mesh.BoundsMax, view.get<Component::Transform>(entity).ToMatrix(), {0.2f, 1.0f, 0.2f, 1.0f}, debugDrawOnTop);
+    }
+  }
+
+  if (showLightRadii) {
+    auto view = m_Scene.GetRegistry()->view<Component::Light, Component::Transform>();
+    for (auto &entity : view) {
+      auto &light = view.get<Component::Light>(entity);
+      math::vec3 position = (view.get<Component::Transform>(entity).ToMatrix() * math::vec4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+      DebugDraw::Sphere(position, light.Radius, math::vec4(light.Color, 1.0f), debugDrawOnTop);
+    }
+  }
+
+  if (showCameraFrusta) {
+    auto view = m_Scene.GetRegistry()->view<Component::Camera, Component::Transform>();
+    for (auto &entity : view) {
+      if (entity == GetActiveCamera().GetHandle())
+        continue;
+      auto viewMatrix = math::inverse(view.get<Component::Transform>(entity).ToMatrix());
+      DebugDraw::Frustum(view.get<Component::Camera>(entity).Projection * viewMatrix, {1.0f, 0.9f, 0.2f, 1.0f}, debugDrawOnTop);
     }
   }
 
@@ -340,6 +443,43 @@ void EditorLayer::OnUIRender(TimeStep deltaTime)
         if (update)
           cameraComponent.Update();
       }
+
+      if (entity.HasComponent<Component::Light>()) {
+        ImGui::Separator();
+        ImGui::LabelText("##Light", "%s", "Light");
+        auto &lightComponent = entity.GetComponent<Component::Light>();
+        ImGui::ColorEdit3("Color", lightComponent.Color.data());
+        ImGui::DragFloat("Intensity", &lightComponent.Intensity, 0.01f, 0.0f, 100.0f);
+        ImGui::DragFloat("Radius", &lightComponent.Radius, 0.05f, 0.0f, 1000.0f);
+      }
+
+      if (entity.HasComponent<Component::ParticleEmitter>()) {
+        ImGui::Separator();
+        ImGui::LabelText("##ParticleEmitter", "%s", "Particle Emitter");
+        auto &emitter = entity.GetComponent<Component::ParticleEmitter>();
+        ImGui::Checkbox("Emitting", &emitter.Emitting);
+        ImGui::DragFloat("Rate", &emitter.Rate, 100.0f, 0.0f, 1000000.0f);
+        ImGui::DragFloat("Lifetime", &emitter.Lifetime, 0.01f, 0.0f, 60.0f);
+        ImGui::DragFloat("Speed", &emitter.Speed, 0.05f, 0.0f, 100.0f);
+        ImGui::DragFloat("Spread", &emitter.Spread, 0.01f, 0.0f, 1.0f);
+        ImGui::DragFloat3("Gravity", emitter.Gravity.data(), 0.05f);
+        ImGui::ColorEdit4("Start Color", emitter.StartColor.data());
+        ImGui::ColorEdit4("End Color", emitter.EndColor.data());
+        ImGui::DragFloat("Start Size", &emitter.StartSize, 0.001f, 0.0f, 10.0f);
+        ImGui::DragFloat("End Size", &emitter.EndSize, 0.001f, 0.0f, 10.0f);
+        ImGui::Text("Particles: %u / %u", emitter.Pool->GetCount(), emitter.Pool->GetCapacity());
+      }
+
+      if (entity.HasComponent<Component::Terrain>() && entity.GetComponent<Component::Terrain>().Field) {
+        ImGui::Separator();
+        ImGui::LabelText("##Terrain", "%s", "Terrain");
+        auto &terrain = entity.GetComponent<Component::Terrain>();
+        ImGui::DragFloat("LOD Distance", &terrain.LodDistance, 0.01f, 0.1f, 16.0f);
+        auto &field = *terrain.Field;
+        ImGui::Text("Samples: %u x %u, depth %u", field.GetWidth(), field.GetHeight(), field.GetMaxDepth());
+        ImGui::Text("Patches: %u", (uint32_t)field.GetPatches().size());
+        ImGui::Text("Slots: %u / %u, pending %u", field.GetResidentCount(), field.GetSlotCount(), field.GetPendingCount());
+      }
     }
   }
 
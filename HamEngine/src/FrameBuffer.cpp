@@ -1,15 +1,18 @@
 #include "Ham/Renderer/FrameBuffer.h"
 
 #include "Ham/Core/Base.h"
+#include "Ham/Debug/RenderStats.h"
 
 #include "glad/gl.h"
 
+#include <fstream>
+
 namespace Ham {
 
 FrameBuffer::FrameBuffer() {}
 
 FrameBuffer::FrameBuffer(const FrameBufferSpecification &spec)
-    : m_Specification(spec)
+    : m_Specification(spec), m_AllocatedWidth(spec.Width), m_AllocatedHeight(spec.Height)
 {
   Invalidate();
 }
@@ -24,11 +27,14 @@ FrameBuffer::~FrameBuffer()
 void FrameBuffer::Init(const FrameBufferSpecification &spec)
 {
   m_Specification = spec;
+  m_AllocatedWidth = spec.Width;
+  m_AllocatedHeight = spec.Height;
   Invalidate();
 }
 
 void FrameBuffer::Bind() const
 {
+  RenderStats::Add(RenderCounter::FRAMEBUFFER_BINDS);
   glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
   glViewport(0, 0, m_Specification.Width, m_Specification.Height);
 }
@@ -42,13 +48,58 @@ void FrameBuffer::Resize(uint32_t width, uint32_t height)
 {
   m_Specification.Width = width;
   m_Specification.Height = height;
+
+  // minimized windows report 0x0, keep the textures for when they come back
+  if (width == 0 || height == 0 || Fits(width, height))
+    return;
+
+  m_AllocatedWidth = (width + SizeClass - 1) / SizeClass * SizeClass;
+  m_AllocatedHeight = (height + SizeClass - 1) / SizeClass * SizeClass;
   Invalidate();
 }
 
+bool FrameBuffer::Fits(uint32_t width, uint32_t height) const
+{
+  return width <= m_AllocatedWidth && height <= m_AllocatedHeight && width * 2 >= m_AllocatedWidth && height * 2 >= m_AllocatedHeight;
+}
+
 void FrameBuffer::Clear(uint32_t attachmentType) const
 {
-  glClearColor(m_Specification.ClearColor.x, m_Specification.ClearColor.y, m_Specification.ClearColor.z, m_Specification.ClearColor.w);
-  glClear(attachmentType);
+  RenderStats::Add(RenderCounter::CLEARS);
+  // glClear with a float color is undefined for integer attachments, so color is cleared per attachment
+  if (attachmentType & AttachmentType::COLOR) {
+    for (uint32_t i = 0; i < m_Specification.ColorAttachments.size(); i++) {
+      if (IsIntegerFormat(m_Specification.ColorAttachments[i])) {
+        GLuint value[4] = {m_Specification.ClearInteger, 0, 0, 0};
+        glClearBufferuiv(GL_COLOR, i, value);
+      }
+      else {
+        glClearBufferfv(GL_COLOR, i, m_Specification.ClearColor.data());
+      }
+    }
+  }
+
+  if (attachmentType & (AttachmentType::DEPTH | AttachmentType::STENCIL))
+    glClear(attachmentType & (AttachmentType::DEPTH | AttachmentType::STENCIL));
+}
+
+void FrameBuffer::Discard(uint32_t attachmentType) const
+{
+  std::vector<GLenum> attachments;
+  if (attachmentType & AttachmentType::COLOR) {
+    for (uint32_t i = 0; i < m_ColorAttachments.size(); i++)
+      attachments.push_back(GL_COLOR_ATTACHMENT0 + i);
+  }
+
+  bool depth = m_Specification.DepthAttachment == TextureFormat::DEPTH24 || m_Specification.DepthAttachment == TextureFormat::DEPTH24_STENCIL8;
+  bool stencil = m_Specification.DepthAttachment == TextureFormat::STENCIL8 || m_Specification.DepthAttachment == TextureFormat::DEPTH24_STENCIL8;
+  if (depth && (attachmentType & AttachmentType::DEPTH))
+    attachments.push_back(GL_DEPTH_ATTACHMENT);
+  if (stencil && (attachmentType & AttachmentType::STENCIL))
+    attachments.push_back(GL_STENCIL_ATTACHMENT);
+
+  if (!attachments.empty())
+    glInvalidateNamedFramebufferData(m_RendererID, (GLsizei)attachments.size(), attachments.data());
 }
 
 void FrameBuffer::SetClearColor(const math::vec4 &color)
@@ -106,11 +157,56 @@ uint32_t FrameBuffer::GetHeight() const
   return m_Specification.Height;
 }
 
+math::vec2 FrameBuffer::GetUVScale() const
+{
+  if (m_AllocatedWidth == 0 || m_AllocatedHeight == 0)
+    return {1.0f, 1.0f};
+  return {(float)m_Specification.Width / m_AllocatedWidth, (float)m_Specification.Height / m_AllocatedHeight};
+}
+
 const FrameBufferSpecification &FrameBuffer::GetSpecification() const
 {
   return m_Specification;
 }
 
+void FrameBuffer::Blit(uint32_t attachment, uint32_t target, uint32_t targetWidth, uint32_t targetHeight) const
+{
+  if (targetWidth == 0 || targetHeight == 0) {
+    targetWidth = m_Specification.Width;
+    targetHeight = m_Specification.Height;
+  }
+
+  // integer attachments can't be filtered
+  bool scaled = targetWidth != m_Specification.Width || targetHeight != m_Specification.Height;
+  GLenum filter = scaled && !IsIntegerFormat(m_Specification.ColorAttachments[attachment]) ? GL_LINEAR : GL_NEAREST;
+
+  RenderStats::Add(RenderCounter::FRAMEBUFFER_BINDS, 2);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_RendererID);
+  glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+  glBlitFramebuffer(0, 0, m_Specification.Width, m_Specification.Height, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, filter);
+  glBindFramebuffer(GL_FRAMEBUFFER, target);
+}
+
+bool FrameBuffer::IsIntegerFormat(TextureFormat format)
+{
+  switch (format) {
+    case TextureFormat::COLOR_RI:
+    case TextureFormat::COLOR_RGI:
+    case TextureFormat::COLOR_RGBI:
+    case TextureFormat::COLOR_RGBAI:
+    case TextureFormat::COLOR_RUI:
+    case TextureFormat::COLOR_RGUI:
+    case TextureFormat::COLOR_RGBUI:
+    case TextureFormat::COLOR_RGBAUI:
+    case TextureFormat::COLOR_R32I:
+    case TextureFormat::COLOR_R32UI:
+      return true;
+    default:
+      return false;
+  }
+}
+
 void FrameBuffer::Invalidate()
 {
   if (m_RendererID) {
@@ -125,15 +221,28 @@ void FrameBuffer::Invalidate()
   glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
 
   bool multisample = m_Specification.Samples > 1;
+  GLenum textureTarget = multisample ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+
+  // immutable storage only needs the sized internal format, so every TextureFormat works as-is
+  auto createTexture = [&](uint32_t &texture, TextureFormat format) {
+    glGenTextures(1, &texture);
+    glBindTexture(textureTarget, texture);
+    if (multisample) {
+      glTexStorage2DMultisample(textureTarget, m_Specification.Samples, (GLenum)format, m_AllocatedWidth, m_AllocatedHeight, GL_TRUE);
+    }
+    else {
+      glTexStorage2D(textureTarget, 1, (GLenum)format, m_AllocatedWidth, m_AllocatedHeight);
+      // integer textures are incomplete with linear filtering
+      bool integer = IsIntegerFormat(format);
+      glTexParameteri(textureTarget, GL_TEXTURE_MIN_FILTER, integer ? GL_NEAREST : m_Specification.MinFilter);
+      glTexParameteri(textureTarget, GL_TEXTURE_MAG_FILTER, integer ? GL_NEAREST : m_Specification.MagFilter);
+    }
+  };
 
   for (uint32_t i = 0; i < m_Specification.ColorAttachments.size(); i++) {
     m_ColorAttachments.emplace_back();
-    glGenTextures(1, &m_ColorAttachments.back());
-    glBindTexture(GL_TEXTURE_2D, m_ColorAttachments.back());
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Specification.Width, m_Specification.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_ColorAttachments.back(), 0);
+    createTexture(m_ColorAttachments.back(), m_Specification.ColorAttachments[i]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, textureTarget, m_ColorAttachments.back(), 0);
 
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if (status != GL_FRAMEBUFFER_COMPLETE) {
@@ -142,10 +251,14 @@ void FrameBuffer::Invalidate()
   }
 
   if (m_Specification.DepthAttachment != TextureFormat::NONE) {
-    glGenTextures(1, &m_DepthAttachment);
-    glBindTexture(GL_TEXTURE_2D, m_DepthAttachment);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, m_Specification.Width, m_Specification.Height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_DepthAttachment, 0);
+    createTexture(m_DepthAttachment, m_Specification.DepthAttachment);
+
+    GLenum attachmentPoint = GL_DEPTH_STENCIL_ATTACHMENT;
+    if (m_Specification.DepthAttachment == TextureFormat::DEPTH24)
+      attachmentPoint = GL_DEPTH_ATTACHMENT;
+    else if (m_Specification.DepthAttachment == TextureFormat::STENCIL8)
+      attachmentPoint = GL_STENCIL_ATTACHMENT;
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachmentPoint, textureTarget, m_DepthAttachment, 0);
 
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if (status != GL_FRAMEBUFFER_COMPLETE) {
@@ -170,21 +283,49 @@ void FrameBuffer::Invalidate()
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-std::vector<unsigned char> FrameBuffer::ReadPixels() const
+std::vector<unsigned char> FrameBuffer::ReadPixels(uint32_t attachment) const
 {
-  std::vector<unsigned char> pixels(m_Specification.Width * m_Specification.Height * 4);
-  glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
-  glReadPixels(0, 0, m_Specification.Width, m_Specification.Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  return pixels;
+  return ReadPixels(0, 0, m_Specification.Width, m_Specification.Height, attachment);
 }
 
-std::vector<unsigned char> FrameBuffer::ReadPixels(int x, int y, int width, int height) const
+std::vector<unsigned char> FrameBuffer::ReadPixels(int x, int y, int width, int height, uint32_t attachment) const
 {
+  HAM_CORE_ASSERT(attachment < m_Specification.ColorAttachments.size(), "Color attachment out of range!");
+  HAM_CORE_ASSERT(!IsIntegerFormat(m_Specification.ColorAttachments[attachment]), "Cannot read an integer attachment as RGBA8!");
+
+  // the read buffer is framebuffer state, set it every time (PixelReadback and Blit pick other attachments)
   std::vector<unsigned char> pixels(width * height * 4);
-  glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_RendererID);
+  glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
   glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
   return pixels;
 }
+
+bool FrameBuffer::SaveToFile(const std::string &path) const
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    HAM_CORE_ERROR("Could not open {0} for writing", path);
+    return false;
+  }
+
+  uint32_t width = m_Specification.Width, height = m_Specification.Height;
+  auto pixels = ReadPixels();
+
+  // GL rows start at the bottom, PPM rows at the top
+  std::vector<unsigned char> row(width * 3);
+  file << "P6\n" << width << " " << height << "\n255\n";
+  for (uint32_t y = 0; y < height; y++) {
+    const unsigned char *source = pixels.data() + (size_t)(height - 1 - y) * width * 4;
+    for (uint32_t x = 0; x < width; x++) {
+      row[x * 3 + 0] = source[x * 4 + 0];
+      row[x * 3 + 1] = source[x * 4 + 1];
+      row[x * 3 + 2] = source[x * 4 + 2];
+    }
+    file.write((const char *)row.data(), row.size());
+  }
+
+  return (bool)file;
+}
 }  // namespace Ham
@@ -0,0 +1,246 @@
+#include "Ham/Renderer/GeometryBuffer.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/RenderStats.h"
+
+#include <algorithm>
+
+namespace Ham {
+
+void RangeAllocator::Init(uint32_t capacity)
+{
+  m_FreeBlocks.clear();
+  m_Capacity = capacity;
+  m_Used = 0;
+  if (capacity > 0)
+    m_FreeBlocks[0] = capacity;
+}
+
+void RangeAllocator::Grow(uint32_t capacity)
+{
+  HAM_CORE_ASSERT(capacity >= m_Capacity, "RangeAllocator can only grow!");
+  if (capacity == m_Capacity)
+    return;
+
+  uint32_t oldCapacity = m_Capacity;
+  m_Capacity = capacity;
+  Free(oldCapacity, capacity - oldCapacity);
+  m_Used += capacity - oldCapacity;  // Free() counted the new tail as released memory
+}
+
+bool RangeAllocator::Allocate(uint32_t size, uint32_t &offset)
+{
+  if (size == 0) {
+    offset = 0;
+    return true;
+  }
+
+  for (auto it = m_FreeBlocks.begin(); it != m_FreeBlocks.end(); it++) {
+    if (it->second < size)
+      continue;
+
+    offset = it->first;
+    uint32_t remaining = it->second - size;
+    m_FreeBlocks.erase(it);
+    if (remaining > 0)
+      m_FreeBlocks[offset + size] = remaining;
+
+    m_Used += size;
+    return true;
+  }
+
+  return false;
+}
+
+void RangeAllocator::Free(uint32_t offset, uint32_t size)
+{
+  if (size == 0)
+    return;
+
+  m_Used -= size;
+  auto next = m_FreeBlocks.lower_bound(offset);
+
+  // merge with the following block
+  if (next != m_FreeBlocks.end() && offset + size == next->first) {
+    size += next->second;
+    next = m_FreeBlocks.erase(next);
+  }
+
+  // merge with the preceding block
+  if (next != m_FreeBlocks.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+
+  m_FreeBlocks[offset] = size;
+}
+
+void GeometryBuffer::Init(const VertexLayout &layout, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+  HAM_CORE_ASSERT(!m_isInitialized, "GeometryBuffer already initialized!");
+  m_VertexStride = layout.GetStride();
+
+  m_VertexArray = VertexArray::Get(layout);
+  m_Vertices.Init(0);
+  m_Indices.Init(0);
+  Reserve(vertexCapacity, indexCapacity);
+
+  m_isInitialized = true;
+}
+
+void GeometryBuffer::Destroy()
+{
+  glDeleteBuffers(1, &m_VertexBufferID);
+  glDeleteBuffers(1, &m_IndexBufferID);
+  m_VertexBufferID = m_IndexBufferID = 0;
+  m_VertexArray.reset();
+
+  m_Allocations.clear();
+  m_FreeHandles.clear();
+  m_isInitialized = false;
+}
+
+uint32_t GeometryBuffer::Allocate(const void *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount)
+{
+  HAM_CORE_ASSERT(m_isInitialized, "GeometryBuffer not initialized!");
+
+  GeometryAllocation allocation;
+  allocation.VertexCount = vertexCount;
+  allocation.IndexCount = indexCount;
+
+  while (!m_Vertices.Allocate(vertexCount, allocation.FirstVertex))
+    Reserve(std::max(m_Vertices.GetCapacity() * 2, m_Vertices.GetCapacity() + vertexCount), m_Indices.GetCapacity());
+
+  while (!m_Indices.Allocate(indexCount, allocation.FirstIndex))
+    Reserve(m_Vertices.GetCapacity(), std::max(m_Indices.GetCapacity() * 2, m_Indices.GetCapacity() + indexCount));
+
+  glNamedBufferSubData(m_VertexBufferID, (GLintptr)allocation.FirstVertex * m_VertexStride, (GLsizeiptr)vertexCount * m_VertexStride, vertices);
+  glNamedBufferSubData(m_IndexBufferID, (GLintptr)allocation.FirstIndex * sizeof(uint32_t), (GLsizeiptr)indexCount * sizeof(uint32_t), indices);
+  RenderStats::Add(RenderCounter::BUFFER_UPLOADS, 2);
+  RenderStats::Add(RenderCounter::UPLOAD_BYTES, (uint64_t)vertexCount * m_VertexStride + (uint64_t)indexCount * sizeof(uint32_t));
+
+  allocation.LastUsedFrame = m_Frame;
+  allocation.Active = true;
+
+  uint32_t index;
+  if (!m_FreeHandles.empty()) {
+    index = m_FreeHandles.back();
+    m_FreeHandles.pop_back();
+    allocation.Generation = (m_Allocations[index].Generation + 1) & (InvalidHandle >> HandleIndexBits);
+    m_Allocations[index] = allocation;
+  }
+  else {
+    index = (uint32_t)m_Allocations.size();
+    HAM_CORE_ASSERT(index < HandleIndexMask, "GeometryBuffer ran out of handles!");
+    m_Allocations.push_back(allocation);
+  }
+
+  return (allocation.Generation << HandleIndexBits) | index;
+}
+
+void GeometryBuffer::UpdateVertices(uint32_t handle, const void *vertices, uint32_t first, uint32_t count)
+{
+  HAM_CORE_ASSERT(IsValid(handle), "Invalid geometry handle!");
+  auto &allocation = m_Allocations[HandleIndex(handle)];
+  HAM_CORE_ASSERT(first + count <= allocation.VertexCount, "Vertex range outside of the allocation!");
+
+  glNamedBufferSubData(m_VertexBufferID, (GLintptr)(allocation.FirstVertex + first) * m_VertexStride, (GLsizeiptr)count * m_VertexStride, vertices);
+  RenderStats::Add(RenderCounter::BUFFER_UPLOADS);
+  RenderStats::Add(RenderCounter::UPLOAD_BYTES, (uint64_t)count * m_VertexStride);
+}
+
+void GeometryBuffer::Free(uint32_t handle)
+{
+  if (!IsValid(handle))
+    return;
+
+  auto &allocation = m_Allocations[HandleIndex(handle)];
+  m_Vertices.Free(allocation.FirstVertex, allocation.VertexCount);
+  m_Indices.Free(allocation.FirstIndex, allocation.IndexCount);
+  allocation.Active = false;
+  m_FreeHandles.push_back(HandleIndex(handle));
+}
+
+bool GeometryBuffer::IsValid(uint32_t handle) const
+{
+  if (handle == InvalidHandle || HandleIndex(handle) >= m_Allocations.size())
+    return false;
+
+  auto &allocation = m_Allocations[HandleIndex(handle)];
+  return allocation.Active && allocation.Generation == HandleGeneration(handle);
+}
+
+const GeometryAllocation &GeometryBuffer::Get(uint32_t handle) const
+{
+  HAM_CORE_ASSERT(IsValid(handle), "Invalid geometry handle!");
+  return m_Allocations[HandleIndex(handle)];
+}
+
+DrawElementsIndirectCommand GeometryBuffer::Use(uint32_t handle, uint32_t baseInstance)
+{
+  HAM_CORE_ASSERT(IsValid(handle), "Invalid geometry handle!");
+  auto &allocation = m_Allocations[HandleIndex(handle)];
+  allocation.LastUsedFrame = m_Frame;
+
+  DrawElementsIndirectCommand command;
+  command.Count = allocation.IndexCount;
+  command.InstanceCount = 1;
+  command.FirstIndex = allocation.FirstIndex;
+  command.BaseVertex = (int32_t)allocation.FirstVertex;
+  command.BaseInstance = baseInstance;
+  return command;
+}
+
+void GeometryBuffer::EndFrame(uint32_t maxUnusedFrames)
+{
+  // destroyed meshes free their allocation themselves (see Application::OnMeshDestroyed), this only catches ones that
+  // were dropped without it, e.g. a Mesh component replaced by another
+  for (uint32_t index = 0; index < m_Allocations.size(); index++) {
+    auto &allocation = m_Allocations[index];
+    if (allocation.Active && allocation.LastUsedFrame + maxUnusedFrames < m_Frame)
+      Free((allocation.Generation << HandleIndexBits) | index);
+  }
+
+  m_Frame++;
+}
+
+void GeometryBuffer::Bind() const
+{
+  m_VertexArray->Bind();
+  m_VertexArray->SetBuffers(m_VertexBufferID, m_IndexBufferID);
+}
+
+void GeometryBuffer::Unbind() const
+{
+  glBindVertexArray(0);
+}
+
+void GeometryBuffer::Reserve(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+  auto grow = [](uint32_t &bufferID, size_t oldSize, size_t newSize) {
+    if (bufferID != 0 && oldSize == newSize)
+      return;
+
+    uint32_t newBufferID;
+    glCreateBuffers(1, &newBufferID);
+    glNamedBufferStorage(newBufferID, (GLsizeiptr)newSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    if (bufferID != 0) {
+      glCopyNamedBufferSubData(bufferID, newBufferID, 0, 0, (GLsizeiptr)oldSize);
+      glDeleteBuffers(1, &bufferID);
+    }
+
+    bufferID = newBufferID;
+  };
+
+  grow(m_VertexBufferID, (size_t)m_Vertices.GetCapacity() * m_VertexStride, (size_t)vertexCapacity * m_VertexStride);
+  grow(m_IndexBufferID, (size_t)m_Indices.GetCapacity() * sizeof(uint32_t), (size_t)indexCapacity * sizeof(uint32_t));
+
+  m_Vertices.Grow(vertexCapacity);
+  m_Indices.Grow(indexCapacity);
+}
+
+}  // namespace Ham
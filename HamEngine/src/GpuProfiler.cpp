@@ -0,0 +1,134 @@
+#include "Ham/Debug/GpuProfiler.h"
+
+#include "Ham/Core/Base.h"
+
+namespace Ham {
+
+bool GpuProfiler::s_Enabled = false;
+GpuProfiler::Frame GpuProfiler::s_Frames[FrameCount];
+uint32_t GpuProfiler::s_FrameIndex = 0;
+uint32_t GpuProfiler::s_DroppedFrames = 0;
+std::vector<GpuZoneResult> GpuProfiler::s_Results;
+std::unordered_map<std::string, float> GpuProfiler::s_Averages;
+
+void GpuProfiler::Init()
+{
+  // some drivers expose the query but count with 0 bits, timestamps would all read 0
+  GLint bits = 0;
+  glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+  if (bits == 0) {
+    HAM_CORE_WARN("GL_TIMESTAMP queries are not supported, GPU timings disabled");
+    return;
+  }
+
+  for (auto &frame : s_Frames)
+    glGenQueries(MaxZones * 2, frame.Queries);
+
+  HAM_PROFILE_GPU_CONTEXT();
+  s_Enabled = true;
+}
+
+void GpuProfiler::Shutdown()
+{
+  if (!s_Enabled)
+    return;
+
+  for (auto &frame : s_Frames) {
+    glDeleteQueries(MaxZones * 2, frame.Queries);
+    frame = Frame();
+  }
+  s_Enabled = false;
+}
+
+void GpuProfiler::BeginFrame()
+{
+  if (!s_Enabled)
+    return;
+
+  s_FrameIndex = (s_FrameIndex + 1) % FrameCount;
+  auto &frame = s_Frames[s_FrameIndex];
+  if (frame.Pending)
+    Resolve(frame);
+
+  frame.Zones.clear();
+  frame.Open.clear();
+  frame.QueryCount = 0;
+  BeginZone("Frame");
+}
+
+void GpuProfiler::EndFrame()
+{
+  if (!s_Enabled)
+    return;
+
+  auto &frame = s_Frames[s_FrameIndex];
+  while (!frame.Open.empty())  // the frame zone and anything left open
+    EndZone();
+
+  frame.Pending = frame.QueryCount > 0;
+  HAM_PROFILE_GPU_COLLECT();
+}
+
+void GpuProfiler::BeginZone(const std::string &name)
+{
+  if (!s_Enabled)
+    return;
+
+  auto &frame = s_Frames[s_FrameIndex];
+  if (frame.QueryCount + 2 > MaxZones * 2) {
+    frame.Open.push_back(UINT32_MAX);  // keeps EndZone balanced
+    return;
+  }
+
+  uint32_t query = frame.QueryCount;
+  frame.QueryCount += 2;  // the end query is reserved now so nested zones don't take it
+  glQueryCounter(frame.Queries[query], GL_TIMESTAMP);
+
+  frame.Zones.push_back({name, (uint32_t)frame.Open.size(), query, query + 1});
+  frame.Open.push_back((uint32_t)frame.Zones.size() - 1);
+}
+
+void GpuProfiler::EndZone()
+{
+  if (!s_Enabled)
+    return;
+
+  auto &frame = s_Frames[s_FrameIndex];
+  HAM_CORE_ASSERT(!frame.Open.empty(), "GpuProfiler::EndZone without BeginZone!");
+  uint32_t zone = frame.Open.back();
+  frame.Open.pop_back();
+
+  if (zone != UINT32_MAX)
+    glQueryCounter(frame.Queries[frame.Zones[zone].EndQuery], GL_TIMESTAMP);
+}
+
+void GpuProfiler::Resolve(Frame &frame)
+{
+  frame.Pending = false;
+
+  // the frame zone's end is the last timestamp written, once it is available all of them are
+  GLint available = GL_FALSE;
+  glGetQueryObjectiv(frame.Queries[frame.Zones[0].EndQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (available != GL_TRUE) {
+    s_DroppedFrames++;
+    return;
+  }
+
+  s_Results.clear();
+  for (auto &zone : frame.Zones) {
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frame.Queries[zone.BeginQuery], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frame.Queries[zone.EndQuery], GL_QUERY_RESULT, &end);
+
+    float milliseconds = end > begin ? (float)(end - begin) / 1000000.0f : 0.0f;
+    auto average = s_Averages.find(zone.Name);
+    if (average == s_Averages.end())
+      average = s_Averages.emplace(zone.Name, milliseconds).first;
+    else
+      average->second += (milliseconds - average->second) * 0.05f;
+
+    s_Results.push_back({zone.Name, zone.Depth, milliseconds, average->second});
+  }
+}
+
+}  // namespace Ham
@@ -0,0 +1,392 @@
+#include "Ham/Scene/Heightfield.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+#include "Ham/Scene/Entity.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Ham {
+
+enum TerrainEdge : uint32_t {
+  TERRAIN_EDGE_LEFT = 1 << 0,  // column 0
+  TERRAIN_EDGE_RIGHT = 1 << 1,
+  TERRAIN_EDGE_BOTTOM = 1 << 2,  // row 0
+  TERRAIN_EDGE_TOP = 1 << 3,
+};
+
+Heightfield::Heightfield(std::vector<float> heights, uint32_t width, uint32_t height, float spacing, uint32_t slotCount)
+    : m_Heights(std::move(heights)), m_Width(width), m_Height(height), m_Spacing(spacing), m_SlotCount(slotCount)
+{
+  HAM_CORE_ASSERT(width >= 2 && height >= 2 && m_Heights.size() == (size_t)width * height, "Invalid heightfield size!");
+  HAM_CORE_ASSERT(slotCount >= 5, "A heightfield needs slots for at least the root and its children!");
+
+  uint32_t tiles = (std::max(width, height) - 1 + TileQuads - 1) / TileQuads;
+  while ((1u << m_MaxDepth) < tiles)
+    m_MaxDepth++;
+
+  for (uint32_t depth = 0; depth <= m_MaxDepth; depth++)
+    for (uint32_t y = 0; y < (1u << depth); y++)
+      for (uint32_t x = 0; x < (1u << depth); x++)
+        m_Nodes.push_back({depth, x, y});
+
+  // bounds of the vertices each node is drawn with
+  JobSystem::ParallelFor((uint32_t)m_Nodes.size(), 16, [this](uint32_t begin, uint32_t end, uint32_t batch) {
+    for (uint32_t index = begin; index < end; index++) {
+      auto &node = m_Nodes[index];
+      int step = (int)GetStep(node.Depth);
+      int baseX = (int)(node.X * TileQuads) * step, baseY = (int)(node.Y * TileQuads) * step;
+      node.BoundsMin = node.BoundsMax = GetPosition(baseX, baseY);
+      for (int j = 0; j < (int)TileSamples; j++) {
+        for (int i = 0; i < (int)TileSamples; i++) {
+          math::vec3 position = GetPosition(baseX + i * step, baseY + j * step);
+          node.BoundsMin = math::min(node.BoundsMin, position);
+          node.BoundsMax = math::max(node.BoundsMax, position);
+        }
+      }
+    }
+  });
+
+  m_TileDepth.resize(GetTileCount() * GetTileCount());
+  m_SlotParents.assign(m_SlotCount, UINT32_MAX);
+  m_SlotLastUsed.assign(m_SlotCount, 0);
+}
+
+Heightfield::~Heightfield()
+{
+  // the jobs write into m_Pending
+  for (auto &pending : m_Pending)
+    JobSystem::Wait(pending->Counter);
+}
+
+std::shared_ptr<Heightfield> Heightfield::Generate(uint32_t width, uint32_t height, float spacing, const std::function<float(float, float)> &function)
+{
+  std::vector<float> heights((size_t)width * height);
+  for (uint32_t y = 0; y < height; y++)
+    for (uint32_t x = 0; x < width; x++)
+      heights[(size_t)y * width + x] = function(x * spacing, y * spacing);
+  return std::make_shared<Heightfield>(std::move(heights), width, height, spacing);
+}
+
+float Heightfield::GetSample(int x, int y) const
+{
+  x = std::clamp(x, 0, (int)m_Width - 1);
+  y = std::clamp(y, 0, (int)m_Height - 1);
+  return m_Heights[(size_t)y * m_Width + x];
+}
+
+math::vec3 Heightfield::GetPosition(int x, int y) const
+{
+  // nodes along the far edges reach past the grid, their extra vertices collapse onto the border
+  x = std::clamp(x, 0, (int)m_Width - 1);
+  y = std::clamp(y, 0, (int)m_Height - 1);
+  return math::right() * (x * m_Spacing) + math::forward() * (y * m_Spacing) + math::up() * m_Heights[(size_t)y * m_Width + x];
+}
+
+void Heightfield::BuildVertices(const Node &node, std::vector<Component::VertexData> &vertices) const
+{
+  vertices.resize(TileVertices);
+
+  int step = (int)GetStep(node.Depth);
+  int baseX = (int)(node.X * TileQuads) * step, baseY = (int)(node.Y * TileQuads) * step;
+  for (int j = 0; j < (int)TileSamples; j++) {
+    for (int i = 0; i < (int)TileSamples; i++) {
+      int x = baseX + i * step, y = baseY + j * step;
+
+      // central differences on the full resolution grid, so every depth shades the same
+      float dx = GetSample(x + 1, y) - GetSample(x - 1, y);
+      float dy = GetSample(x, y + 1) - GetSample(x, y - 1);
+      math::vec3 normal = math::up() * (2.0f * m_Spacing) - math::right() * dx - math::forward() * dy;
+
+      vertices[j * TileSamples + i] = {GetPosition(x, y), math::normalize(normal)};
+    }
+  }
+}
+
+// One triangle list per combination of edges that border a coarser node. On those edges every odd vertex is moved
+// onto the even one before it, which turns the edge into the straight segments the coarser neighbour draws.
+// The triangles this collapses are left out.
+void Heightfield::BuildIndices()
+{
+  std::vector<uint32_t> indices;
+  for (uint32_t mask = 0; mask < 16; mask++) {
+    m_VariantOffsets[mask] = (uint32_t)indices.size();
+
+    auto vertex = [mask](uint32_t i, uint32_t j) {
+      if ((j & 1) && (((mask & TERRAIN_EDGE_LEFT) && i == 0) || ((mask & TERRAIN_EDGE_RIGHT) && i == TileQuads)))
+        j--;
+      if ((i & 1) && (((mask & TERRAIN_EDGE_BOTTOM) && j == 0) || ((mask & TERRAIN_EDGE_TOP) && j == TileQuads)))
+        i--;
+      return j * TileSamples + i;
+    };
+
+    auto triangle = [&indices](uint32_t a, uint32_t b, uint32_t c) {
+      if (a == b || b == c || c == a)
+        return;
+      indices.insert(indices.end(), {a, b, c});
+    };
+
+    for (uint32_t j = 0; j < TileQuads; j++) {
+      for (uint32_t i = 0; i < TileQuads; i++) {
+        uint32_t a = vertex(i, j), b = vertex(i + 1, j), c = vertex(i + 1, j + 1), d = vertex(i, j + 1);
+        triangle(a, b, c);
+        triangle(a, c, d);
+      }
+    }
+
+    m_VariantCounts[mask] = (uint32_t)indices.size() - m_VariantOffsets[mask];
+  }
+
+  m_Indices.Create();
+  m_Indices.SetDrawMode(DrawMode::STATIC);
+  m_Indices.SetData(indices);
+}
+
+void Heightfield::Update(const math::vec3 &cameraPosition, float lodDistance)
+{
+  HAM_PROFILE_SCOPE();
+
+  m_Frame++;
+
+  if (!m_Vertices.IsInitialized()) {
+    m_Vertices.Create();
+    m_Vertices.SetDrawMode(DrawMode::DYNAMIC);
+    m_Vertices.SetData(std::vector<Component::VertexData>((size_t)m_SlotCount * 4 * TileVertices));
+    BuildIndices();
+
+    // the root is built right away and never evicted, everything else streams in below it
+    std::vector<Component::VertexData> vertices;
+    BuildVertices(m_Nodes[0], vertices);
+    auto tile = m_Vertices.Modify(0, TileVertices);
+    std::copy(vertices.begin(), vertices.end(), tile.begin());
+    m_Nodes[0].State = NodeState::RESIDENT;
+    m_Nodes[0].Tile = 0;
+    m_ResidentCount = 1;
+  }
+
+  UploadFinished();
+
+  // The selection works on the depth of the node covering each leaf tile: the depth wanted from camera distance,
+  // raised until neighbours are at most one depth apart, cut back where children aren't resident yet and
+  // lowered again until neighbours are one depth apart. Lowering only ever ends on nodes that were walked through.
+  m_PreviousUsedCount = m_UsedCount;
+  m_UsedCount = 0;
+  std::fill(m_TileDepth.begin(), m_TileDepth.end(), 0);
+  SelectByDistance(0, 0, 0, cameraPosition, lodDistance);
+  while (Balance(true)) {}
+  SelectResident(0, 0, 0);
+  while (Balance(false)) {}
+
+  m_Patches.clear();
+  CollectPatches(0, 0, 0);
+}
+
+void Heightfield::UploadFinished()
+{
+  for (size_t i = 0; i < m_Pending.size();) {
+    auto &pending = *m_Pending[i];
+    if (pending.Counter.Pending > 0) {
+      i++;
+      continue;
+    }
+
+    auto &parent = m_Nodes[pending.Parent];
+    int32_t slot = AcquireSlot();
+    for (uint32_t child = 0; child < 4; child++) {
+      auto &node = m_Nodes[GetChildIndex(parent.Depth, parent.X, parent.Y, child)];
+      node.State = slot < 0 ? NodeState::EMPTY : NodeState::RESIDENT;  // every slot is in use, asked for again once one frees up
+      node.Tile = slot < 0 ? -1 : slot * 4 + (int32_t)child;
+    }
+
+    if (slot >= 0) {
+      auto vertices = m_Vertices.Modify((size_t)slot * 4 * TileVertices, 4 * TileVertices);
+      std::copy(pending.Vertices.begin(), pending.Vertices.end(), vertices.begin());
+      m_SlotParents[slot] = pending.Parent;
+      m_SlotLastUsed[slot] = m_Frame;
+      m_ResidentCount++;
+    }
+
+    m_Pending.erase(m_Pending.begin() + i);
+  }
+
+  if (m_Vertices.IsDirty())
+    m_Vertices.Flush();
+}
+
+void Heightfield::RequestChildren(uint32_t parent)
+{
+  // nothing would make room for them, the count from last frame is complete while this frame's is still growing
+  uint32_t used = std::max(m_UsedCount, m_PreviousUsedCount);
+  if (m_Pending.size() >= MaxPendingSplits || 1 + used + m_Pending.size() >= m_SlotCount)
+    return;
+
+  auto &node = m_Nodes[parent];
+  Node children[4];
+  for (uint32_t child = 0; child < 4; child++) {
+    auto &childNode = m_Nodes[GetChildIndex(node.Depth, node.X, node.Y, child)];
+    childNode.State = NodeState::PENDING;
+    children[child] = childNode;
+  }
+
+  auto &pending = m_Pending.emplace_back(std::make_unique<PendingSplit>());
+  pending->Parent = parent;
+  pending->Vertices.resize(4 * TileVertices);
+  JobSystem::Execute(
+      [this, pending = pending.get(), children]() {
+        std::vector<Component::VertexData> vertices;
+        for (uint32_t child = 0; child < 4; child++) {
+          BuildVertices(children[child], vertices);
+          std::copy(vertices.begin(), vertices.end(), pending->Vertices.begin() + child * TileVertices);
+        }
+      },
+      pending->Counter);
+}
+
+int32_t Heightfield::AcquireSlot()
+{
+  // a free slot, otherwise the least recently used one. Slots used last frame are most likely wanted again, those
+  // are never evicted so a cache too small for the view settles on coarser nodes instead of thrashing
+  int32_t victim = -1;
+  for (uint32_t slot = 1; slot < m_SlotCount; slot++) {
+    if (m_SlotParents[slot] == UINT32_MAX)
+      return (int32_t)slot;
+    if (m_SlotLastUsed[slot] + 1 >= m_Frame)
+      continue;
+    if (victim < 0 || m_SlotLastUsed[slot] < m_SlotLastUsed[victim])
+      victim = (int32_t)slot;
+  }
+
+  if (victim >= 0) {
+    auto &parent = m_Nodes[m_SlotParents[victim]];
+    for (uint32_t child = 0; child < 4; child++) {
+      auto &node = m_Nodes[GetChildIndex(parent.Depth, parent.X, parent.Y, child)];
+      node.State = NodeState::EMPTY;
+      node.Tile = -1;
+    }
+    m_ResidentCount--;
+  }
+  return victim;
+}
+
+void Heightfield::SetBlock(uint32_t depth, uint32_t x, uint32_t y, uint8_t value, bool raise)
+{
+  uint32_t size = GetTileCount() >> depth;
+  for (uint32_t ty = y * size; ty < (y + 1) * size; ty++) {
+    for (uint32_t tx = x * size; tx < (x + 1) * size; tx++) {
+      auto &tile = TileDepth(tx, ty);
+      tile = raise ? std::max(tile, value) : std::min(tile, value);
+    }
+  }
+}
+
+void Heightfield::SelectByDistance(uint32_t depth, uint32_t x, uint32_t y, const math::vec3 &cameraPosition, float lodDistance)
+{
+  auto &node = m_Nodes[GetNodeIndex(depth, x, y)];
+
+  float distance = 0.0f;
+  for (int axis = 0; axis < 3; axis++) {
+    float closest = std::clamp(cameraPosition[axis], node.BoundsMin[axis], node.BoundsMax[axis]);
+    distance += (cameraPosition[axis] - closest) * (cameraPosition[axis] - closest);
+  }
+
+  float size = (float)(TileQuads * GetStep(depth)) * m_Spacing;
+  if (depth == m_MaxDepth || std::sqrt(distance) >= lodDistance * size) {
+    SetBlock(depth, x, y, (uint8_t)depth, true);
+    return;
+  }
+
+  for (uint32_t child = 0; child < 4; child++)
+    SelectByDistance(depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1), cameraPosition, lodDistance);
+}
+
+void Heightfield::SelectResident(uint32_t depth, uint32_t x, uint32_t y)
+{
+  uint32_t size = GetTileCount() >> depth;
+  if (TileDepth(x * size, y * size) == depth)
+    return;
+
+  // children are always built, stored and evicted together
+  uint32_t index = GetNodeIndex(depth, x, y);
+  auto &first = m_Nodes[GetChildIndex(depth, x, y, 0)];
+  if (first.State != NodeState::RESIDENT) {
+    if (first.State == NodeState::EMPTY)
+      RequestChildren(index);
+    SetBlock(depth, x, y, (uint8_t)depth, false);
+    return;
+  }
+
+  m_SlotLastUsed[first.Tile / 4] = m_Frame;
+  m_UsedCount++;
+  for (uint32_t child = 0; child < 4; child++)
+    SelectResident(depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1));
+}
+
+// Raising splits the coarser side of a pair of tiles more than one depth apart, lowering merges the finer side
+bool Heightfield::Balance(bool raise)
+{
+  static constexpr int offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+  bool changed = false;
+  int tiles = (int)GetTileCount();
+  for (int ty = 0; ty < tiles; ty++) {
+    for (int tx = 0; tx < tiles; tx++) {
+      for (auto &offset : offsets) {
+        int nx = tx + offset[0], ny = ty + offset[1];
+        if (nx < 0 || ny < 0 || nx >= tiles || ny >= tiles)
+          continue;
+
+        uint32_t depth = TileDepth(tx, ty), neighbour = TileDepth(nx, ny);
+        if (depth <= neighbour + 1)
+          continue;
+
+        if (raise) {
+          for (uint32_t level = neighbour; level + 1 < depth; level++)
+            SetBlock(level, nx >> (m_MaxDepth - level), ny >> (m_MaxDepth - level), (uint8_t)(level + 1), true);
+        }
+        else {
+          uint32_t level = neighbour + 1;
+          SetBlock(level, tx >> (m_MaxDepth - level), ty >> (m_MaxDepth - level), (uint8_t)level, false);
+        }
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+void Heightfield::CollectPatches(uint32_t depth, uint32_t x, uint32_t y)
+{
+  uint32_t size = GetTileCount() >> depth;
+  uint32_t tx = x * size, ty = y * size;
+  if (TileDepth(tx, ty) > depth) {
+    for (uint32_t child = 0; child < 4; child++)
+      CollectPatches(depth + 1, x * 2 + (child & 1), y * 2 + (child >> 1));
+    return;
+  }
+
+  // a neighbour is never more than one depth coarser, so one tile along each edge tells
+  uint32_t mask = 0;
+  if (tx > 0 && TileDepth(tx - 1, ty) < depth)
+    mask |= TERRAIN_EDGE_LEFT;
+  if (tx + size < GetTileCount() && TileDepth(tx + size, ty) < depth)
+    mask |= TERRAIN_EDGE_RIGHT;
+  if (ty > 0 && TileDepth(tx, ty - 1) < depth)
+    mask |= TERRAIN_EDGE_BOTTOM;
+  if (ty + size < GetTileCount() && TileDepth(tx, ty + size) < depth)
+    mask |= TERRAIN_EDGE_TOP;
+
+  uint32_t index = GetNodeIndex(depth, x, y);
+  auto &node = m_Nodes[index];
+  HAM_CORE_ASSERT(node.State == NodeState::RESIDENT, "Selected a terrain node that isn't resident!");
+
+  DrawElementsIndirectCommand command;
+  command.Count = m_VariantCounts[mask];
+  command.InstanceCount = 1;
+  command.FirstIndex = m_VariantOffsets[mask];
+  command.BaseVertex = node.Tile * (int32_t)TileVertices;
+  command.BaseInstance = 0;
+  m_Patches.push_back({index, node.BoundsMin, node.BoundsMax, command});
+}
+
+}  // namespace Ham
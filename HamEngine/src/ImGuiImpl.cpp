@@ -34,11 +34,12 @@ void ImGuiImpl::Init(Window *window)
   settings_file_path = (FileSystem::GetExecutableDir() / settings_file_name).string();
 
   // if file doesn't exist, copy default settings file from assets
-  if (!std::filesystem::exists(settings_file_path)) {
+  if (!m_Window->IsHeadless() && !std::filesystem::exists(settings_file_path)) {
     std::filesystem::copy(ASSETS_PATH_CORE "default_config.ini", settings_file_path);
   }
 
-  io.IniFilename = settings_file_path.c_str();
+  // headless runs must be reproducible, so they neither read nor overwrite the user's settings
+  io.IniFilename = m_Window->IsHeadless() ? nullptr : settings_file_path.c_str();
 
   m_ImGuiSettingsHandler.UserData = m_Window->m_Application;
   m_ImGuiSettingsHandler.TypeName = "AppSettings";
@@ -47,7 +48,8 @@ void ImGuiImpl::Init(Window *window)
   m_ImGuiSettingsHandler.ReadLineFn = &Window::ReadLineCallback;
   m_ImGuiSettingsHandler.WriteAllFn = &Window::WriteAllCallback;
   GImGui->SettingsHandlers.push_back(m_ImGuiSettingsHandler);
-  ImGui::LoadIniSettingsFromDisk(io.IniFilename);
+  if (io.IniFilename != nullptr)
+    ImGui::LoadIniSettingsFromDisk(io.IniFilename);
 
   io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;  // Enable Keyboard Controls
   io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;   // Enable Gamepad Controls
@@ -56,6 +58,9 @@ void ImGuiImpl::Init(Window *window)
                                                          // io.ConfigViewportsNoAutoMerge = true;
                                                          // io.ConfigViewportsNoTaskBarIcon = true;
 
+  if (m_Window->IsHeadless())
+    io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+
 #if defined(HAM_PLATFORM_LINUX) || defined(HAM_PLATFORM_MACOS)
   io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;  // FIXME: Viewports are not currently working on Linux/MacOS
 #endif
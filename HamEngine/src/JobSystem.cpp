@@ -0,0 +1,140 @@
+#include "Ham/Util/JobSystem.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+
+#include <algorithm>
+
+namespace Ham {
+std::vector<std::thread> JobSystem::s_Threads;
+std::deque<JobSystem::Job> JobSystem::s_Jobs;
+std::mutex JobSystem::s_Mutex;
+std::condition_variable JobSystem::s_Condition;
+bool JobSystem::s_Running = false;
+
+void JobSystem::Init(uint32_t threadCount)
+{
+  HAM_CORE_ASSERT(!s_Running, "JobSystem already initialized!");
+
+  if (threadCount == 0) {
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    threadCount = hardwareThreads > 3 ? hardwareThreads - 2 : 1;
+  }
+
+  s_Running = true;
+  for (uint32_t i = 0; i < threadCount; i++)
+    s_Threads.emplace_back(&JobSystem::WorkerThread, i);
+
+  HAM_CORE_INFO("JobSystem started with {0} worker threads", threadCount);
+}
+
+void JobSystem::Shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Running = false;
+  }
+  s_Condition.notify_all();
+
+  for (auto &thread : s_Threads) {
+    if (thread.joinable())
+      thread.join();
+  }
+  s_Threads.clear();
+}
+
+void JobSystem::Execute(const std::function<void()> &job, Counter &counter)
+{
+  counter.Pending++;
+
+  if (s_Threads.empty()) {  // not initialized, run inline
+    job();
+    counter.Pending--;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Jobs.push_back({job, &counter});
+  }
+  s_Condition.notify_one();
+}
+
+void JobSystem::Wait(Counter &counter)
+{
+  while (counter.Pending > 0) {
+    if (!RunPendingJob())
+      std::this_thread::yield();
+  }
+}
+
+uint32_t JobSystem::GetBatchCount(uint32_t count, uint32_t minBatchSize)
+{
+  if (count == 0)
+    return 0;
+
+  uint32_t maxBatches = GetThreadCount() + 1;  // the waiting thread works too
+  uint32_t batches = (count + minBatchSize - 1) / std::max(minBatchSize, 1u);
+  return std::clamp(batches, 1u, maxBatches);
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t, uint32_t)> &func)
+{
+  uint32_t batches = GetBatchCount(count, minBatchSize);
+  if (batches == 0)
+    return;
+
+  if (batches == 1) {
+    func(0, count, 0);
+    return;
+  }
+
+  Counter counter;
+  uint32_t batchSize = (count + batches - 1) / batches;
+  for (uint32_t batch = 1; batch < batches; batch++) {
+    uint32_t begin = batch * batchSize;
+    uint32_t end = std::min(begin + batchSize, count);
+    Execute([&func, begin, end, batch]() { func(begin, end, batch); }, counter);
+  }
+
+  func(0, std::min(batchSize, count), 0);
+  Wait(counter);
+}
+
+bool JobSystem::RunPendingJob()
+{
+  Job job;
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    if (s_Jobs.empty())
+      return false;
+    job = std::move(s_Jobs.front());
+    s_Jobs.pop_front();
+  }
+
+  job.Function();
+  job.Owner->Pending--;
+  return true;
+}
+
+void JobSystem::WorkerThread(uint32_t index)
+{
+  HAM_PROFILE_THREAD("Job Worker");
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(s_Mutex);
+      s_Condition.wait(lock, []() { return !s_Running || !s_Jobs.empty(); });
+      if (!s_Running && s_Jobs.empty())
+        return;
+      job = std::move(s_Jobs.front());
+      s_Jobs.pop_front();
+    }
+
+    job.Function();
+    job.Owner->Pending--;
+  }
+}
+
+}  // namespace Ham
@@ -0,0 +1,156 @@
+#include "Ham/Renderer/LightClusters.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+#include "Ham/Util/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Ham {
+
+void LightClusters::BeginFrame(const math::mat4 &view, const math::mat4 &projection, float near, float far)
+{
+  HAM_CORE_ASSERT(near > 0.0f && far > std::max(near, MinNear), "Invalid cluster depth range!");
+
+  m_View = view;
+  m_ScaleX = projection(0, 0);
+  m_ScaleY = projection(1, 1);
+  m_CameraNear = near;
+  m_Near = std::max(near, MinNear);
+  m_Far = far;
+  m_LogDepthRatio = std::log(m_Far / m_Near);
+
+  m_Lights.clear();
+  m_Bounds.clear();
+}
+
+void LightClusters::AddLight(const math::vec3 &position, const math::vec3 &color, float intensity, float radius)
+{
+  if (radius <= 0.0f || intensity <= 0.0f)
+    return;
+
+  math::vec3 viewPosition = (m_View * math::vec4(position, 1.0f)).xyz;
+  float depth = -viewPosition.z;
+  if (depth + radius < m_CameraNear || depth - radius > m_Far)
+    return;
+
+  m_Lights.push_back({math::vec4(viewPosition, radius), math::vec4(color, intensity)});
+  m_Bounds.push_back({GetSlice(depth - radius), GetSlice(depth + radius)});
+}
+
+void LightClusters::Build()
+{
+  HAM_PROFILE_SCOPE();
+
+  m_Clusters.resize(ClusterCount);
+  m_SliceIndices.resize(Slices);
+
+  JobSystem::ParallelFor(Slices, 1, [this](uint32_t begin, uint32_t end, uint32_t batch) {
+    for (uint32_t slice = begin; slice < end; slice++)
+      BinSlice(slice);
+  });
+
+  // slices store offsets into their own list, rebase them onto the concatenated one
+  m_Indices.clear();
+  m_MaxPerCluster = 0;
+  for (uint32_t slice = 0; slice < Slices; slice++) {
+    uint32_t base = (uint32_t)m_Indices.size();
+    for (uint32_t cluster = GetClusterIndex(0, 0, slice); cluster < GetClusterIndex(0, 0, slice + 1); cluster++) {
+      m_Clusters[cluster].Offset += base;
+      m_MaxPerCluster = std::max(m_MaxPerCluster, m_Clusters[cluster].Count);
+    }
+    m_Indices.insert(m_Indices.end(), m_SliceIndices[slice].begin(), m_SliceIndices[slice].end());
+  }
+}
+
+uint32_t LightClusters::GetSlice(float depth) const
+{
+  if (depth <= m_Near)
+    return 0;
+  float slice = std::log(depth / m_Near) / m_LogDepthRatio * Slices;
+  return std::min((uint32_t)slice, Slices - 1);
+}
+
+float LightClusters::GetSliceDepth(uint32_t slice) const
+{
+  return m_Near * std::exp(m_LogDepthRatio * (float)slice / Slices);
+}
+
+void LightClusters::BinSlice(uint32_t slice)
+{
+  struct Candidate {
+    uint32_t Light;
+    int MinX, MinY, MaxX, MaxY;
+  };
+  static thread_local std::vector<Candidate> candidates;
+  candidates.clear();
+
+  auto &indices = m_SliceIndices[slice];
+  indices.clear();
+
+  float nearDepth = slice == 0 ? m_CameraNear : GetSliceDepth(slice);
+  float farDepth = GetSliceDepth(slice + 1);
+
+  // screen rectangle of each light's bounding box over the part of the slice it covers
+  for (uint32_t i = 0; i < (uint32_t)m_Lights.size(); i++) {
+    if (slice < m_Bounds[i].MinSlice || slice > m_Bounds[i].MaxSlice)
+      continue;
+
+    auto &light = m_Lights[i].PositionRadius;
+    float depth = -light.z;
+    float d0 = std::max(nearDepth, depth - light.w);
+    float d1 = std::min(farDepth, depth + light.w);
+
+    auto tileRange = [&](float center, float scale, uint32_t tiles, int &minTile, int &maxTile) {
+      float low = center - light.w, high = center + light.w;
+      float minNdc = std::min(low / d0, low / d1) * scale;
+      float maxNdc = std::max(high / d0, high / d1) * scale;
+      minTile = (int)std::floor((minNdc * 0.5f + 0.5f) * tiles);
+      maxTile = (int)std::floor((maxNdc * 0.5f + 0.5f) * tiles);
+      minTile = std::max(minTile, 0);
+      maxTile = std::min(maxTile, (int)tiles - 1);
+      return minTile <= maxTile;
+    };
+
+    Candidate candidate = {i};
+    if (tileRange(light.x, m_ScaleX, TilesX, candidate.MinX, candidate.MaxX) && tileRange(light.y, m_ScaleY, TilesY, candidate.MinY, candidate.MaxY))
+      candidates.push_back(candidate);
+  }
+
+  for (uint32_t y = 0; y < TilesY; y++) {
+    for (uint32_t x = 0; x < TilesX; x++) {
+      auto &cluster = m_Clusters[GetClusterIndex(x, y, slice)];
+      cluster.Offset = (uint32_t)indices.size();
+
+      for (auto &candidate : candidates) {
+        if ((int)x < candidate.MinX || (int)x > candidate.MaxX || (int)y < candidate.MinY || (int)y > candidate.MaxY)
+          continue;
+        if (Intersects(m_Lights[candidate.Light], x, y, nearDepth, farDepth))
+          indices.push_back(candidate.Light);
+      }
+
+      cluster.Count = (uint32_t)indices.size() - cluster.Offset;
+    }
+  }
+}
+
+bool LightClusters::Intersects(const ClusterLight &light, uint32_t x, uint32_t y, float nearDepth, float farDepth) const
+{
+  // view space bounding box of the froxel against the light's sphere
+  float x0 = (float)x / TilesX * 2.0f - 1.0f, x1 = (float)(x + 1) / TilesX * 2.0f - 1.0f;
+  float y0 = (float)y / TilesY * 2.0f - 1.0f, y1 = (float)(y + 1) / TilesY * 2.0f - 1.0f;
+
+  math::vec3 boxMin = {std::min(x0 * nearDepth, x0 * farDepth) / m_ScaleX, std::min(y0 * nearDepth, y0 * farDepth) / m_ScaleY, -farDepth};
+  math::vec3 boxMax = {std::max(x1 * nearDepth, x1 * farDepth) / m_ScaleX, std::max(y1 * nearDepth, y1 * farDepth) / m_ScaleY, -nearDepth};
+
+  float distance = 0.0f;
+  for (int axis = 0; axis < 3; axis++) {
+    float value = light.PositionRadius[axis];
+    float closest = std::clamp(value, boxMin[axis], boxMax[axis]);
+    distance += (value - closest) * (value - closest);
+  }
+  return distance <= light.PositionRadius.w * light.PositionRadius.w;
+}
+
+}  // namespace Ham
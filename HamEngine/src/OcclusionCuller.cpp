@@ -0,0 +1,283 @@
+#include "Ham/Renderer/OcclusionCuller.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+#include "Ham/Util/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAM_OCCLUSION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Ham {
+
+void OcclusionCuller::Init(uint32_t width, uint32_t height)
+{
+  HAM_CORE_ASSERT(width % 4 == 0, "OcclusionCuller width must be a multiple of 4!");
+  m_Width = width;
+  m_Height = height;
+  m_Depth.assign((size_t)width * height, 1.0f);
+
+  m_HiZ.clear();
+  uint32_t levelWidth = width, levelHeight = height;
+  while (levelWidth > 1 || levelHeight > 1) {
+    levelWidth = std::max(1u, (levelWidth + 1) / 2);
+    levelHeight = std::max(1u, (levelHeight + 1) / 2);
+    m_HiZ.push_back({levelWidth, levelHeight, std::vector<float>((size_t)levelWidth * levelHeight, 1.0f)});
+  }
+}
+
+void OcclusionCuller::BeginFrame(const math::mat4 &viewProjection)
+{
+  m_ViewProjection = viewProjection;
+  m_Triangles.clear();
+  m_HasOccluders = false;
+  m_Tested = 0;
+  m_Culled = 0;
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<math::vec3> &vertices, const std::vector<uint32_t> &indices, const math::mat4 &model)
+{
+  static thread_local std::vector<math::vec4> clip;
+
+  math::mat4 mvp = m_ViewProjection * model;
+  clip.resize(vertices.size());
+  for (size_t i = 0; i < vertices.size(); i++)
+    clip[i] = mvp * math::vec4(vertices[i], 1.0f);
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    AddClippedTriangle(clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]]);
+}
+
+void OcclusionCuller::AddClippedTriangle(const math::vec4 &a, const math::vec4 &b, const math::vec4 &c)
+{
+  // clip against the near plane (z > -w), a triangle becomes at most a quad
+  math::vec4 input[3] = {a, b, c};
+  math::vec4 output[4];
+  int count = 0;
+
+  for (int i = 0; i < 3; i++) {
+    const math::vec4 &current = input[i];
+    const math::vec4 &next = input[(i + 1) % 3];
+    float currentDistance = current.z + current.w;
+    float nextDistance = next.z + next.w;
+
+    if (currentDistance >= 0.0f)
+      output[count++] = current;
+    if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+      float t = currentDistance / (currentDistance - nextDistance);
+      output[count++] = current + (next - current) * t;
+    }
+  }
+
+  for (int i = 1; i + 1 < count; i++) {
+    ScreenTriangle triangle;
+    const math::vec4 *corners[3] = {&output[0], &output[i], &output[i + 1]};
+    bool valid = true;
+
+    for (int v = 0; v < 3; v++) {
+      float w = corners[v]->w;
+      if (w <= 1e-6f) {
+        valid = false;
+        break;
+      }
+      triangle.X[v] = (corners[v]->x / w * 0.5f + 0.5f) * m_Width;
+      triangle.Y[v] = (corners[v]->y / w * 0.5f + 0.5f) * m_Height;
+      triangle.Z[v] = corners[v]->z / w * 0.5f + 0.5f;
+    }
+
+    if (!valid)
+      continue;
+
+    float minY = std::min({triangle.Y[0], triangle.Y[1], triangle.Y[2]});
+    float maxY = std::max({triangle.Y[0], triangle.Y[1], triangle.Y[2]});
+    float minX = std::min({triangle.X[0], triangle.X[1], triangle.X[2]});
+    float maxX = std::max({triangle.X[0], triangle.X[1], triangle.X[2]});
+    if (maxY < 0.0f || minY > (float)m_Height || maxX < 0.0f || minX > (float)m_Width)
+      continue;
+
+    triangle.MinY = std::max(0, (int)std::floor(minY));
+    triangle.MaxY = std::min((int)m_Height - 1, (int)std::ceil(maxY));
+    m_Triangles.push_back(triangle);
+  }
+}
+
+void OcclusionCuller::Rasterize()
+{
+  HAM_PROFILE_SCOPE();
+
+  m_HasOccluders = !m_Triangles.empty();
+  if (!m_HasOccluders)
+    return;
+
+  // bands own disjoint rows, so workers never touch the same pixels
+  JobSystem::ParallelFor(m_Height, 16, [this](uint32_t begin, uint32_t end, uint32_t batch) {
+    RasterizeBand((int)begin, (int)end);
+  });
+
+  BuildHiZ();
+}
+
+void OcclusionCuller::RasterizeBand(int yBegin, int yEnd)
+{
+  std::fill(m_Depth.begin() + (size_t)yBegin * m_Width, m_Depth.begin() + (size_t)yEnd * m_Width, 1.0f);
+
+  for (auto &triangle : m_Triangles) {
+    if (triangle.MaxY < yBegin || triangle.MinY >= yEnd)
+      continue;
+    RasterizeTriangle(triangle, yBegin, yEnd);
+  }
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenTriangle &triangle, int yBegin, int yEnd)
+{
+  float x0 = triangle.X[0], y0 = triangle.Y[0];
+  float x1 = triangle.X[1], y1 = triangle.Y[1];
+  float x2 = triangle.X[2], y2 = triangle.Y[2];
+  float z0 = triangle.Z[0], z1 = triangle.Z[1], z2 = triangle.Z[2];
+
+  float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+  if (std::abs(area) < 1e-8f)
+    return;
+
+  // occluders are rasterized double sided, flip clockwise triangles so the edge functions are positive inside
+  if (area < 0.0f) {
+    std::swap(x1, x2);
+    std::swap(y1, y2);
+    std::swap(z1, z2);
+    area = -area;
+  }
+
+  // edge functions E(x, y) = A * x + B * y + C
+  float a0 = y1 - y2, b0 = x2 - x1, c0 = x1 * y2 - x2 * y1;
+  float a1 = y2 - y0, b1 = x0 - x2, c1 = x2 * y0 - x0 * y2;
+  float a2 = y0 - y1, b2 = x1 - x0, c2 = x0 * y1 - x1 * y0;
+
+  // depth is linear in screen space after the perspective divide
+  float dzdx = ((z1 - z0) * (y2 - y0) - (z2 - z0) * (y1 - y0)) / area;
+  float dzdy = ((z2 - z0) * (x1 - x0) - (z1 - z0) * (x2 - x0)) / area;
+
+  int minX = std::max(0, (int)std::floor(std::min({x0, x1, x2})));
+  int maxX = std::min((int)m_Width - 1, (int)std::ceil(std::max({x0, x1, x2})));
+  int minY = std::max(yBegin, triangle.MinY);
+  int maxY = std::min(yEnd - 1, triangle.MaxY);
+  if (minX > maxX || minY > maxY)
+    return;
+
+  minX &= ~3;  // start on a 4 pixel boundary so rows can be processed with aligned SIMD lanes
+
+  for (int y = minY; y <= maxY; y++) {
+    float py = (float)y + 0.5f;
+    float *row = m_Depth.data() + (size_t)y * m_Width;
+
+#ifdef HAM_OCCLUSION_SSE
+    __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 zero = _mm_setzero_ps();
+    for (int x = minX; x <= maxX; x += 4) {
+      __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+
+      __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(b0 * py + c0));
+      __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(b1 * py + c1));
+      __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(b2 * py + c2));
+      __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+      if (_mm_movemask_ps(inside) == 0)
+        continue;
+
+      __m128 z = _mm_add_ps(_mm_set1_ps(z0 + dzdy * (py - y0) - dzdx * x0), _mm_mul_ps(_mm_set1_ps(dzdx), px));
+      __m128 previous = _mm_loadu_ps(row + x);
+      __m128 nearest = _mm_min_ps(previous, z);
+      _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+    }
+#else
+    for (int x = minX; x <= maxX; x++) {
+      float px = (float)x + 0.5f;
+      if (a0 * px + b0 * py + c0 < 0.0f || a1 * px + b1 * py + c1 < 0.0f || a2 * px + b2 * py + c2 < 0.0f)
+        continue;
+      float z = z0 + dzdx * (px - x0) + dzdy * (py - y0);
+      row[x] = std::min(row[x], z);
+    }
+#endif
+  }
+}
+
+void OcclusionCuller::BuildHiZ()
+{
+  const float *source = m_Depth.data();
+  uint32_t sourceWidth = m_Width, sourceHeight = m_Height;
+
+  for (auto &level : m_HiZ) {
+    for (uint32_t y = 0; y < level.Height; y++) {
+      uint32_t sy0 = std::min(y * 2, sourceHeight - 1), sy1 = std::min(y * 2 + 1, sourceHeight - 1);
+      for (uint32_t x = 0; x < level.Width; x++) {
+        uint32_t sx0 = std::min(x * 2, sourceWidth - 1), sx1 = std::min(x * 2 + 1, sourceWidth - 1);
+        level.Depth[(size_t)y * level.Width + x] = std::max(
+            std::max(source[(size_t)sy0 * sourceWidth + sx0], source[(size_t)sy0 * sourceWidth + sx1]),
+            std::max(source[(size_t)sy1 * sourceWidth + sx0], source[(size_t)sy1 * sourceWidth + sx1]));
+      }
+    }
+
+    source = level.Depth.data();
+    sourceWidth = level.Width;
+    sourceHeight = level.Height;
+  }
+}
+
+bool OcclusionCuller::IsVisible(const math::vec3 &boundsMin, const math::vec3 &boundsMax, const math::mat4 &model) const
+{
+  if (!m_Enabled || !m_HasOccluders)
+    return true;
+
+  m_Tested++;
+
+  math::mat4 mvp = m_ViewProjection * model;
+  float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+
+  for (int i = 0; i < 8; i++) {
+    math::vec3 corner = {(i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z};
+    math::vec4 clip = mvp * math::vec4(corner, 1.0f);
+
+    // crosses the near plane, can't be behind anything
+    if (clip.w <= 1e-6f || clip.z < -clip.w)
+      return true;
+
+    float x = (clip.x / clip.w * 0.5f + 0.5f) * m_Width;
+    float y = (clip.y / clip.w * 0.5f + 0.5f) * m_Height;
+    minX = std::min(minX, x);
+    maxX = std::max(maxX, x);
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+    minZ = std::min(minZ, clip.z / clip.w * 0.5f + 0.5f);
+  }
+
+  int x0 = std::max(0, (int)std::floor(minX));
+  int y0 = std::max(0, (int)std::floor(minY));
+  int x1 = std::min((int)m_Width - 1, (int)std::floor(maxX));
+  int y1 = std::min((int)m_Height - 1, (int)std::floor(maxY));
+  if (x0 > x1 || y0 > y1)  // off screen, frustum culling isn't our job
+    return true;
+
+  // pick the level where the box spans at most a few texels
+  uint32_t level = 0;
+  while (level < m_HiZ.size() && std::max(x1 - x0, y1 - y0) > 3) {
+    x0 >>= 1, y0 >>= 1, x1 >>= 1, y1 >>= 1;
+    level++;
+  }
+
+  const float *depth = level == 0 ? m_Depth.data() : m_HiZ[level - 1].Depth.data();
+  uint32_t width = level == 0 ? m_Width : m_HiZ[level - 1].Width;
+
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) {
+      if (minZ <= depth[(size_t)y * width + x])
+        return true;
+    }
+  }
+
+  m_Culled++;
+  return false;
+}
+
+}  // namespace Ham
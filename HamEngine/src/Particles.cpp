@@ -0,0 +1,148 @@
+#include "Ham/Scene/Particles.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Util/Random.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAM_PARTICLES_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Ham {
+
+void ParticlePool::Reserve(uint32_t capacity)
+{
+  if (capacity == GetCapacity())
+    return;
+
+  // unroll the ring so the kept particles start at index 0
+  uint32_t keep = std::min(m_Count, capacity);
+  auto resize = [&](std::vector<float> &values) {
+    std::vector<float> resized(capacity);
+    for (uint32_t i = 0; i < keep; i++)
+      resized[i] = values[GetIndex(m_Count - keep + i)];
+    values.swap(resized);
+  };
+  resize(m_PositionX);
+  resize(m_PositionY);
+  resize(m_PositionZ);
+  resize(m_VelocityX);
+  resize(m_VelocityY);
+  resize(m_VelocityZ);
+  resize(m_Age);
+
+  m_Head = 0;
+  m_Count = keep;
+}
+
+void ParticlePool::Retire(float deltaTime, float lifetime)
+{
+  // ages only grow towards the head, so the dead ones are a prefix
+  while (m_Count > 0 && m_Age[m_Head] + deltaTime >= lifetime) {
+    m_Head = m_Head + 1 == GetCapacity() ? 0 : m_Head + 1;
+    m_Count--;
+  }
+}
+
+uint32_t ParticlePool::Emit(float deltaTime, float rate, const math::vec3 &origin, const math::vec3 &direction, float speed, float spread)
+{
+  m_EmitRemainder += std::max(rate, 0.0f) * deltaTime;
+  uint32_t count = (uint32_t)m_EmitRemainder;
+  m_EmitRemainder -= (float)count;
+  count = std::min(count, GetCapacity() - m_Count);
+
+  for (uint32_t i = 0; i < count; i++) {
+    math::vec3 velocity = direction + Random::Vec3Dir() * spread;
+    float length = math::length(velocity);
+    velocity = (length > 0.0001f ? velocity / length : direction) * speed;
+
+    // born is when in the frame the particle appears, so the earliest (oldest) ones go first and ages keep growing
+    // towards the head
+    float born = deltaTime * ((float)i + Random::Float()) / (float)count;
+    uint32_t index = GetIndex(m_Count++);
+    m_PositionX[index] = origin.x - velocity.x * born;
+    m_PositionY[index] = origin.y - velocity.y * born;
+    m_PositionZ[index] = origin.z - velocity.z * born;
+    m_VelocityX[index] = velocity.x;
+    m_VelocityY[index] = velocity.y;
+    m_VelocityZ[index] = velocity.z;
+    m_Age[index] = -born;
+  }
+  return count;
+}
+
+void ParticlePool::Simulate(uint32_t begin, uint32_t end, float deltaTime, const math::vec3 &gravity, float lifetime, ParticleInstance *out)
+{
+  HAM_CORE_ASSERT(begin <= end && end <= m_Count, "Particle range out of bounds!");
+  if (begin == end)
+    return;
+
+  // the range is contiguous in the ring unless it wraps past the end
+  float invLifetime = lifetime > 0.0f ? 1.0f / lifetime : 0.0f;
+  uint32_t index = GetIndex(begin);
+  uint32_t first = std::min(end - begin, GetCapacity() - index);
+  SimulateRange(index, first, deltaTime, gravity, invLifetime, out);
+  SimulateRange(0, end - begin - first, deltaTime, gravity, invLifetime, out + first);
+}
+
+void ParticlePool::SimulateRange(uint32_t index, uint32_t count, float deltaTime, const math::vec3 &gravity, float invLifetime, ParticleInstance *out)
+{
+  float *px = m_PositionX.data() + index, *py = m_PositionY.data() + index, *pz = m_PositionZ.data() + index;
+  float *vx = m_VelocityX.data() + index, *vy = m_VelocityY.data() + index, *vz = m_VelocityZ.data() + index;
+  float *age = m_Age.data() + index;
+
+  uint32_t i = 0;
+#ifdef HAM_PARTICLES_SSE
+  __m128 dt = _mm_set1_ps(deltaTime);
+  __m128 gx = _mm_set1_ps(gravity.x * deltaTime), gy = _mm_set1_ps(gravity.y * deltaTime), gz = _mm_set1_ps(gravity.z * deltaTime);
+  __m128 scale = _mm_set1_ps(invLifetime);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(vx + i), y = _mm_loadu_ps(vy + i), z = _mm_loadu_ps(vz + i);
+    x = _mm_add_ps(x, gx);
+    y = _mm_add_ps(y, gy);
+    z = _mm_add_ps(z, gz);
+    _mm_storeu_ps(vx + i, x);
+    _mm_storeu_ps(vy + i, y);
+    _mm_storeu_ps(vz + i, z);
+
+    x = _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(x, dt));
+    y = _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(y, dt));
+    z = _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(z, dt));
+    __m128 a = _mm_add_ps(_mm_loadu_ps(age + i), dt);
+    _mm_storeu_ps(px + i, x);
+    _mm_storeu_ps(py + i, y);
+    _mm_storeu_ps(pz + i, z);
+    _mm_storeu_ps(age + i, a);
+
+    // four columns of x, y, z, age become four ParticleInstance rows, written in order into the mapped buffer
+    a = _mm_mul_ps(a, scale);
+    _MM_TRANSPOSE4_PS(x, y, z, a);
+    _mm_storeu_ps(&out[i].X, x);
+    _mm_storeu_ps(&out[i + 1].X, y);
+    _mm_storeu_ps(&out[i + 2].X, z);
+    _mm_storeu_ps(&out[i + 3].X, a);
+  }
+#endif
+
+  for (; i < count; i++) {
+    vx[i] += gravity.x * deltaTime;
+    vy[i] += gravity.y * deltaTime;
+    vz[i] += gravity.z * deltaTime;
+    px[i] += vx[i] * deltaTime;
+    py[i] += vy[i] * deltaTime;
+    pz[i] += vz[i] * deltaTime;
+    age[i] += deltaTime;
+    out[i] = {px[i], py[i], pz[i], age[i] * invLifetime};
+  }
+}
+
+void ParticlePool::Clear()
+{
+  m_Head = 0;
+  m_Count = 0;
+  m_EmitRemainder = 0.0f;
+}
+
+}  // namespace Ham
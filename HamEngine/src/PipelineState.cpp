@@ -0,0 +1,131 @@
+#include "Ham/Renderer/PipelineState.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/RenderStats.h"
+#include "Ham/Renderer/RenderCommand.h"
+#include "Ham/Renderer/Shader.h"
+
+#include <glad/gl.h>
+
+#include <functional>
+#include <limits>
+
+namespace Ham {
+
+std::array<PipelineState, PipelineCache::MaxPipelines> PipelineCache::s_States;
+std::atomic_uint32_t PipelineCache::s_Count = 0;
+std::unordered_map<PipelineState, PipelineID, PipelineCache::Hasher> PipelineCache::s_IDs;
+std::mutex PipelineCache::s_Mutex;
+PipelineState PipelineCache::s_Current;
+PipelineID PipelineCache::s_CurrentID = 0;
+bool PipelineCache::s_HasCurrent = false;
+
+static_assert(PipelineCache::MaxPipelines - 1 <= std::numeric_limits<PipelineID>::max(), "PipelineID too small for MaxPipelines!");
+
+PipelineState PipelineState::FromFlags(Shader *program, uint32_t flags)
+{
+  PipelineState state;
+  state.Program = program;
+  state.DepthTest = (flags & RENDER_STATE_DEPTH_TEST) != 0;
+  state.Cull = (flags & RENDER_STATE_CULL_BACK) ? CullMode::BACK : CullMode::NONE;
+  state.Blend = (flags & RENDER_STATE_ALPHA_BLEND) ? BlendMode::ALPHA : BlendMode::NONE;
+  state.Polygon = (flags & RENDER_STATE_WIREFRAME) ? PolygonMode::LINE : PolygonMode::FILL;
+  return state;
+}
+
+bool PipelineState::operator==(const PipelineState &other) const
+{
+  return ProgramHandle == other.ProgramHandle && DepthTest == other.DepthTest && DepthWrite == other.DepthWrite && WriteEntityID == other.WriteEntityID &&
+         Cull == other.Cull && Blend == other.Blend && Polygon == other.Polygon;
+}
+
+size_t PipelineCache::Hasher::operator()(const PipelineState &state) const
+{
+  uint32_t bits = (uint32_t)state.DepthTest | (uint32_t)state.DepthWrite << 1 | (uint32_t)state.WriteEntityID << 2 | (uint32_t)state.Cull << 3 |
+                  (uint32_t)state.Blend << 5 | (uint32_t)state.Polygon << 7;
+  return std::hash<uint32_t>()(state.ProgramHandle) ^ ((size_t)bits * 0x9E3779B97F4A7C15ull);
+}
+
+PipelineID PipelineCache::Get(const PipelineState &state)
+{
+  // keyed on the handle, a new shader at a freed shader's address must not reuse its states
+  PipelineState key = state;
+  key.ProgramHandle = state.Program != nullptr ? state.Program->GetHandle() : 0;
+
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  auto it = s_IDs.find(key);
+  if (it != s_IDs.end())
+    return it->second;
+
+  uint32_t count = s_Count.load(std::memory_order_relaxed);
+  HAM_CORE_ASSERT(count < MaxPipelines, "Too many pipeline states!");
+  PipelineID id = (PipelineID)count;
+  s_States[id] = key;
+  s_Count.store(count + 1, std::memory_order_release);
+  s_IDs.emplace(key, id);
+  return id;
+}
+
+void PipelineCache::Bind(PipelineID id)
+{
+  if (s_HasCurrent && id == s_CurrentID)
+    return;
+
+  HAM_CORE_ASSERT(id < GetCount(), "Unknown pipeline state!");
+  PipelineState state = GetState(id);
+  bool all = !s_HasCurrent;
+  const PipelineState &current = s_Current;
+  RenderStats::Add(RenderCounter::STATE_CHANGES);
+
+  if (state.Program != nullptr && (all || state.Program != current.Program))
+    state.Program->Bind();
+
+  if (all || state.DepthTest != current.DepthTest) {
+    if (state.DepthTest)
+      glEnable(GL_DEPTH_TEST);
+    else
+      glDisable(GL_DEPTH_TEST);
+  }
+
+  if (all || state.DepthWrite != current.DepthWrite)
+    glDepthMask(state.DepthWrite ? GL_TRUE : GL_FALSE);
+
+  if (all || state.WriteEntityID != current.WriteEntityID) {
+    GLboolean write = state.WriteEntityID ? GL_TRUE : GL_FALSE;
+    glColorMaski(1, write, write, write, write);
+  }
+
+  if (all || state.Cull != current.Cull) {
+    if (state.Cull == CullMode::BACK) {
+      glEnable(GL_CULL_FACE);
+      glCullFace(GL_BACK);
+    }
+    else {
+      glDisable(GL_CULL_FACE);
+    }
+  }
+
+  if (all || state.Blend != current.Blend) {
+    if (state.Blend == BlendMode::NONE) {
+      glDisable(GL_BLEND);
+    }
+    else {
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, state.Blend == BlendMode::ADDITIVE ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+      glBlendEquation(GL_FUNC_ADD);
+    }
+  }
+
+  if (all || state.Polygon != current.Polygon)
+    glPolygonMode(GL_FRONT_AND_BACK, state.Polygon == PolygonMode::LINE ? GL_LINE : GL_FILL);
+
+  // a state without a program leaves the bound one alone
+  if (state.Program == nullptr && !all)
+    state.Program = current.Program;
+
+  s_Current = state;
+  s_CurrentID = id;
+  s_HasCurrent = true;
+}
+
+}  // namespace Ham
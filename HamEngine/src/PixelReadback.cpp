@@ -0,0 +1,91 @@
+#include "Ham/Renderer/PixelReadback.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Renderer/FrameBuffer.h"
+
+namespace Ham {
+
+void PixelReadback::Init(uint32_t maxWidth, uint32_t maxHeight, uint32_t bytesPerPixel)
+{
+  HAM_CORE_ASSERT(!m_isInitialized, "PixelReadback already initialized!");
+  m_BytesPerPixel = bytesPerPixel;
+  m_Capacity = (size_t)maxWidth * maxHeight * bytesPerPixel;
+
+  for (auto &slot : m_Slots) {
+    glGenBuffers(1, &slot.BufferID);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID);
+    glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)m_Capacity, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  m_isInitialized = true;
+}
+
+void PixelReadback::Destroy()
+{
+  for (auto &slot : m_Slots) {
+    if (slot.Fence != nullptr)
+      glDeleteSync(slot.Fence);
+    glDeleteBuffers(1, &slot.BufferID);
+    slot = Slot();
+  }
+
+  m_Head = m_Tail = m_Pending = 0;
+  m_isInitialized = false;
+}
+
+bool PixelReadback::Request(const FrameBuffer &frameBuffer, uint32_t attachment, int x, int y, int width, int height, uint32_t format, uint32_t type, uint64_t userData)
+{
+  HAM_CORE_ASSERT(m_isInitialized, "PixelReadback not initialized!");
+  HAM_CORE_ASSERT((size_t)width * height * m_BytesPerPixel <= m_Capacity, "PixelReadback region too large!");
+
+  if (m_Pending == RingSize)
+    return false;
+
+  auto &slot = m_Slots[m_Head];
+  slot.Size = (size_t)width * height * m_BytesPerPixel;
+  slot.UserData = userData;
+
+  // with a pack buffer bound glReadPixels only queues the copy and returns immediately
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer.GetRendererID());
+  glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID);
+  glReadPixels(x, y, width, height, format, type, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);  // the read buffer sticks to the framebuffer, leave the default behind
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  m_Head = (m_Head + 1) % RingSize;
+  m_Pending++;
+  return true;
+}
+
+bool PixelReadback::Poll(std::vector<unsigned char> &pixels, uint64_t &userData)
+{
+  if (m_Pending == 0)
+    return false;
+
+  auto &slot = m_Slots[m_Tail];
+
+  GLint status = GL_UNSIGNALED;
+  glGetSynciv(slot.Fence, GL_SYNC_STATUS, 1, nullptr, &status);
+  if (status != GL_SIGNALED)
+    return false;
+
+  pixels.resize(slot.Size);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID);
+  glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)slot.Size, pixels.data());
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  glDeleteSync(slot.Fence);
+  slot.Fence = nullptr;
+  userData = slot.UserData;
+
+  m_Tail = (m_Tail + 1) % RingSize;
+  m_Pending--;
+  return true;
+}
+
+}  // namespace Ham
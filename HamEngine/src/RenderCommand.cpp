@@ -0,0 +1,183 @@
+#include "Ham/Renderer/RenderCommand.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/RenderStats.h"
+#include "Ham/Renderer/Buffer.h"
+#include "Ham/Renderer/Shader.h"
+
+#include <glad/gl.h>
+
+namespace Ham {
+
+void RenderCommandList::Clear()
+{
+  m_Commands.clear();
+  m_FrameData.clear();
+  m_ObjectData.clear();
+
+  m_HasPipeline = false;
+  m_CurrentVertexArray = nullptr;
+  m_CurrentVertexBuffer = 0;
+  m_CurrentIndexBuffer = 0;
+  for (auto &buffer : m_CurrentStorageBuffers)
+    buffer = 0;
+  m_DrawCount = 0;
+}
+
+void RenderCommandList::BindPipeline(PipelineID pipeline)
+{
+  if (m_HasPipeline && pipeline == m_CurrentPipeline)
+    return;
+
+  RenderCommand command;
+  command.Type = RenderCommandType::BIND_PIPELINE;
+  command.Pipeline = pipeline;
+  m_Commands.push_back(command);
+  m_CurrentPipeline = pipeline;
+  m_HasPipeline = true;
+}
+
+void RenderCommandList::BindVertexArray(const VertexArray *vertexArray, uint32_t vertexBuffer, uint32_t indexBuffer)
+{
+  if (vertexArray != m_CurrentVertexArray) {
+    RenderCommand command;
+    command.Type = RenderCommandType::BIND_VERTEX_ARRAY;
+    command.VAO = vertexArray;
+    m_Commands.push_back(command);
+    m_CurrentVertexArray = vertexArray;
+    m_CurrentVertexBuffer = m_CurrentIndexBuffer = 0;  // another list may have attached different buffers since
+  }
+
+  if (vertexBuffer == m_CurrentVertexBuffer && indexBuffer == m_CurrentIndexBuffer)
+    return;
+
+  RenderCommand command;
+  command.Type = RenderCommandType::BIND_VERTEX_BUFFERS;
+  command.VertexBuffers.Vertex = vertexBuffer;
+  command.VertexBuffers.Index = indexBuffer;
+  m_Commands.push_back(command);
+  m_CurrentVertexBuffer = vertexBuffer;
+  m_CurrentIndexBuffer = indexBuffer;
+}
+
+void RenderCommandList::BindStorageBuffer(uint32_t binding, uint32_t buffer)
+{
+  HAM_CORE_ASSERT(binding < MaxStorageBufferBindings, "Storage buffer binding out of range!");
+  if (buffer == m_CurrentStorageBuffers[binding])
+    return;
+
+  RenderCommand command;
+  command.Type = RenderCommandType::BIND_STORAGE_BUFFER;
+  command.StorageBuffer.Binding = binding;
+  command.StorageBuffer.Buffer = buffer;
+  m_Commands.push_back(command);
+  m_CurrentStorageBuffers[binding] = buffer;
+}
+
+void RenderCommandList::SetFrameData(const FrameData &data)
+{
+  RenderCommand command;
+  command.Type = RenderCommandType::SET_FRAME_DATA;
+  command.DataIndex = (uint32_t)m_FrameData.size();
+  m_Commands.push_back(command);
+  m_FrameData.push_back(data);
+}
+
+void RenderCommandList::SetObjectData(const ObjectData &data)
+{
+  RenderCommand command;
+  command.Type = RenderCommandType::SET_OBJECT_DATA;
+  command.DataIndex = (uint32_t)m_ObjectData.size();
+  m_Commands.push_back(command);
+  m_ObjectData.push_back(data);
+}
+
+void RenderCommandList::DrawElements(uint32_t count, uint32_t firstIndex)
+{
+  RenderCommand command;
+  command.Type = RenderCommandType::DRAW_ELEMENTS;
+  command.Draw.Count = count;
+  command.Draw.FirstIndex = firstIndex;
+  m_Commands.push_back(command);
+  m_DrawCount++;
+}
+
+void RenderCommandList::DrawLinesInstanced(uint32_t count, uint32_t instances)
+{
+  RenderCommand command;
+  command.Type = RenderCommandType::DRAW_LINES_INSTANCED;
+  command.InstancedDraw.Count = count;
+  command.InstancedDraw.Instances = instances;
+  m_Commands.push_back(command);
+  m_DrawCount++;
+}
+
+void RenderCommandList::ApplyFrameData(Shader &shader, const FrameData &data)
+{
+  shader.SetUniformMat4f("uView", data.View);
+  shader.SetUniformMat4f("uProjection", data.Projection);
+
+  shader.SetUniform3f("uAmbientLight", data.AmbientLight);
+  shader.SetUniform2f("uClusterDepthRange", data.ClusterDepthRange);
+  shader.SetUniform1f("uTime", data.Time);
+  shader.SetUniform2f("uResolution", data.Resolution);
+
+  shader.SetUniform3f("uObjectColor", data.ObjectColor);
+  shader.SetUniform3f("uWireframeColor", data.WireframeColor);
+}
+
+void RenderCommandList::Execute() const
+{
+  Shader *shader = nullptr;
+  const VertexArray *vertexArray = nullptr;
+  const FrameData *frame = nullptr;
+
+  for (auto &command : m_Commands) {
+    switch (command.Type) {
+      case RenderCommandType::BIND_PIPELINE: {
+        Shader *program = PipelineCache::GetState(command.Pipeline).Program;
+        PipelineCache::Bind(command.Pipeline);
+        if (program != shader && frame != nullptr)  // uniforms are per program, carry the frame data over
+          ApplyFrameData(*program, *frame);
+        shader = program;
+        break;
+      }
+      case RenderCommandType::BIND_VERTEX_ARRAY:
+        vertexArray = command.VAO;
+        vertexArray->Bind();
+        break;
+      case RenderCommandType::BIND_VERTEX_BUFFERS:
+        RenderStats::Add(RenderCounter::STATE_CHANGES);
+        vertexArray->SetBuffers(command.VertexBuffers.Vertex, command.VertexBuffers.Index);
+        break;
+      case RenderCommandType::BIND_STORAGE_BUFFER:
+        RenderStats::Add(RenderCounter::STATE_CHANGES);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, command.StorageBuffer.Binding, command.StorageBuffer.Buffer);
+        break;
+      case RenderCommandType::SET_FRAME_DATA:
+        frame = &m_FrameData[command.DataIndex];
+        if (shader != nullptr)
+          ApplyFrameData(*shader, *frame);
+        break;
+      case RenderCommandType::SET_OBJECT_DATA: {
+        auto &object = m_ObjectData[command.DataIndex];
+        shader->SetUniformMat4f("uModel", object.Model);
+        shader->SetUniformMat4f("uNormalMatrix", object.Normal);
+        shader->SetUniform1i("uID", object.ID);
+        shader->SetUniform1i("uIsWireframe", object.IsWireframe);
+        break;
+      }
+      case RenderCommandType::DRAW_ELEMENTS:
+        RenderStats::Add(RenderCounter::DRAW_CALLS);
+        RenderStats::Add(RenderCounter::TRIANGLES, command.Draw.Count / 3);
+        glDrawElements(GL_TRIANGLES, command.Draw.Count, GL_UNSIGNED_INT, (void *)(command.Draw.FirstIndex * sizeof(uint32_t)));
+        break;
+      case RenderCommandType::DRAW_LINES_INSTANCED:
+        RenderStats::Add(RenderCounter::DRAW_CALLS);
+        glDrawArraysInstanced(GL_LINES, 0, command.InstancedDraw.Count, command.InstancedDraw.Instances);
+        break;
+    }
+  }
+}
+
+}  // namespace Ham
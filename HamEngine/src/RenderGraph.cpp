@@ -0,0 +1,281 @@
+#include "Ham/Renderer/RenderGraph.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/GpuProfiler.h"
+#include "Ham/Debug/RenderStats.h"
+
+#include "glad/gl.h"
+
+#include <algorithm>
+
+namespace Ham {
+
+RenderGraphResource RenderGraphBuilder::Create(const std::string &name, const FrameBufferSpecification &spec)
+{
+  auto &resource = m_Graph.m_Resources.emplace_back();
+  resource.Name = name;
+  resource.Spec = spec;
+  return (RenderGraphResource)m_Graph.m_Resources.size() - 1;
+}
+
+void RenderGraphBuilder::Read(RenderGraphResource resource)
+{
+  HAM_CORE_ASSERT(resource < m_Graph.m_Resources.size(), "Invalid render graph resource!");
+  m_Graph.m_Passes[m_Pass].Reads.push_back(resource);
+}
+
+void RenderGraphBuilder::Write(RenderGraphResource resource, uint32_t clear)
+{
+  HAM_CORE_ASSERT(resource < m_Graph.m_Resources.size(), "Invalid render graph resource!");
+  auto &pass = m_Graph.m_Passes[m_Pass];
+  pass.Writes.push_back({resource, clear});
+
+  uint32_t attachments = RenderGraph::GetAttachmentMask(m_Graph.m_Resources[resource]);
+  if ((clear & attachments) != attachments)
+    pass.Reads.push_back(resource);
+}
+
+void RenderGraphBuilder::SideEffect()
+{
+  m_Graph.m_Passes[m_Pass].SideEffect = true;
+}
+
+void RenderGraph::Reset()
+{
+  m_Resources.clear();
+  m_Passes.clear();
+  m_PhysicalTargets.clear();
+  m_Compiled = false;
+}
+
+RenderGraphResource RenderGraph::Import(const std::string &name, FrameBuffer *frameBuffer, uint32_t discard)
+{
+  auto &resource = m_Resources.emplace_back();
+  resource.Name = name;
+  resource.Imported = true;
+  resource.Target = frameBuffer;
+  resource.Discard = discard;
+  if (frameBuffer != nullptr)
+    resource.Spec = frameBuffer->GetSpecification();
+  return (RenderGraphResource)m_Resources.size() - 1;
+}
+
+void RenderGraph::AddPass(const std::string &name, const SetupFunction &setup, const ExecuteFunction &execute)
+{
+  HAM_CORE_ASSERT(!m_Compiled, "Passes must be added before the graph is compiled!");
+  auto &pass = m_Passes.emplace_back();
+  pass.Name = name;
+  pass.Execute = execute;
+
+  RenderGraphBuilder builder(*this, (uint32_t)m_Passes.size() - 1);
+  setup(builder);
+}
+
+void RenderGraph::Compile()
+{
+  HAM_PROFILE_SCOPE();
+
+  // walk backwards: a pass is needed if something later reads what it writes. A write that clears every attachment
+  // hides all earlier contents, so anything written before that doesn't matter to the passes after it.
+  std::vector<bool> needed(m_Resources.size(), false);
+  for (int index = (int)m_Passes.size() - 1; index >= 0; index--) {
+    auto &pass = m_Passes[index];
+
+    bool alive = pass.SideEffect;
+    for (auto &[resource, clear] : pass.Writes)
+      alive = alive || m_Resources[resource].Imported || needed[resource];
+
+    pass.Culled = !alive;
+    if (pass.Culled)
+      continue;
+
+    for (auto &[resource, clear] : pass.Writes)
+      needed[resource] = false;
+    for (auto resource : pass.Reads)
+      needed[resource] = true;
+  }
+
+  // lifetimes over the passes that survived
+  for (int index = 0; index < (int)m_Passes.size(); index++) {
+    auto &pass = m_Passes[index];
+    if (pass.Culled)
+      continue;
+
+    auto touch = [&](RenderGraphResource id, bool write, uint32_t clear) {
+      auto &resource = m_Resources[id];
+      if (resource.FirstPass < 0) {
+        resource.FirstPass = index;
+        // a transient's first contents are whatever the previous user of its memory left, never load those
+        if (!resource.Imported)
+          resource.InsertedClear = GetAttachmentMask(resource) & ~(write ? clear : 0);
+      }
+      resource.LastPass = index;
+    };
+
+    for (auto &[resource, clear] : pass.Writes)
+      touch(resource, true, clear);
+    for (auto resource : pass.Reads)
+      touch(resource, false, 0);
+  }
+
+  // transients in order of first use, each takes the first compatible framebuffer that is free again
+  std::vector<RenderGraphResource> transients;
+  for (RenderGraphResource id = 0; id < m_Resources.size(); id++) {
+    if (!m_Resources[id].Imported && m_Resources[id].FirstPass >= 0)
+      transients.push_back(id);
+  }
+  std::sort(transients.begin(), transients.end(), [this](RenderGraphResource a, RenderGraphResource b) { return m_Resources[a].FirstPass < m_Resources[b].FirstPass; });
+
+  for (auto id : transients) {
+    auto &resource = m_Resources[id];
+    for (int physical = 0; physical < (int)m_PhysicalTargets.size(); physical++) {
+      auto &target = m_PhysicalTargets[physical];
+      if (target.LastPass < resource.FirstPass && CanAlias(target.Spec, resource.Spec)) {
+        resource.Physical = physical;
+        target.LastPass = resource.LastPass;
+        break;
+      }
+    }
+
+    if (resource.Physical < 0) {
+      resource.Physical = (int)m_PhysicalTargets.size();
+      m_PhysicalTargets.push_back({resource.Spec, resource.LastPass});
+    }
+  }
+
+  m_PassCount = (uint32_t)m_Passes.size();
+  m_CulledPassCount = (uint32_t)std::count_if(m_Passes.begin(), m_Passes.end(), [](const Pass &pass) { return pass.Culled; });
+  m_TransientCount = (uint32_t)transients.size();
+  m_PhysicalTargetCount = (uint32_t)m_PhysicalTargets.size();
+  m_Compiled = true;
+}
+
+void RenderGraph::Execute(RenderTargetPool &pool)
+{
+  HAM_PROFILE_SCOPE();
+  HAM_CORE_ASSERT(m_Compiled, "Render graph must be compiled before it is executed!");
+
+  for (auto &target : m_PhysicalTargets)
+    target.Target = pool.Acquire(target.Spec);
+  for (auto &resource : m_Resources) {
+    if (resource.Physical >= 0)
+      resource.Target = m_PhysicalTargets[resource.Physical].Target;
+  }
+
+  for (int index = 0; index < (int)m_Passes.size(); index++) {
+    auto &pass = m_Passes[index];
+    if (pass.Culled)
+      continue;
+
+    HAM_PROFILE_GPU_SCOPE(pass.Name.c_str());
+    for (auto &[id, clear] : pass.Writes) {
+      auto &resource = m_Resources[id];
+      uint32_t mask = clear | (resource.FirstPass == index ? resource.InsertedClear : 0);
+      if (mask != 0)
+        ClearTarget(resource, mask);
+    }
+
+    // read before anything wrote it, at least make it defined
+    for (auto id : pass.Reads) {
+      auto &resource = m_Resources[id];
+      bool written = std::any_of(pass.Writes.begin(), pass.Writes.end(), [id](const auto &write) { return write.first == id; });
+      if (resource.FirstPass == index && resource.InsertedClear != 0 && !written)
+        ClearTarget(resource, resource.InsertedClear);
+    }
+
+    // the first write is the render target, passes writing more than one bind the others themselves
+    if (!pass.Writes.empty()) {
+      auto &resource = m_Resources[pass.Writes[0].first];
+      if (resource.Target != nullptr) {
+        resource.Target->Bind();
+      }
+      else {
+        RenderStats::Add(RenderCounter::FRAMEBUFFER_BINDS);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      }
+    }
+
+    pass.Execute(*this);
+
+    for (auto &resource : m_Resources) {
+      if (resource.LastPass != index)
+        continue;
+
+      uint32_t discard = resource.Imported ? resource.Discard : GetAttachmentMask(resource);
+      if (discard != 0)
+        DiscardTarget(resource, discard);
+    }
+  }
+
+  // the targets go back to the pool so passes outside the graph can borrow them this frame
+  for (auto &target : m_PhysicalTargets)
+    pool.Release(target.Target);
+}
+
+FrameBuffer *RenderGraph::GetFrameBuffer(RenderGraphResource resource) const
+{
+  HAM_CORE_ASSERT(resource < m_Resources.size(), "Invalid render graph resource!");
+  return m_Resources[resource].Target;
+}
+
+uint32_t RenderGraph::GetAttachmentMask(const Resource &resource)
+{
+  if (resource.Imported && resource.Target == nullptr)
+    return AttachmentType::COLOR | AttachmentType::DEPTH | AttachmentType::STENCIL;
+
+  uint32_t mask = resource.Spec.ColorAttachments.empty() ? 0 : AttachmentType::COLOR;
+  switch (resource.Spec.DepthAttachment) {
+    case TextureFormat::DEPTH24:
+      mask |= AttachmentType::DEPTH;
+      break;
+    case TextureFormat::STENCIL8:
+      mask |= AttachmentType::STENCIL;
+      break;
+    case TextureFormat::DEPTH24_STENCIL8:
+      mask |= AttachmentType::DEPTH | AttachmentType::STENCIL;
+      break;
+    default:
+      break;
+  }
+  return mask;
+}
+
+bool RenderGraph::CanAlias(const FrameBufferSpecification &a, const FrameBufferSpecification &b)
+{
+  return a.Width == b.Width && a.Height == b.Height && a.ColorAttachments == b.ColorAttachments && a.DepthAttachment == b.DepthAttachment && a.Samples == b.Samples && a.MinFilter == b.MinFilter && a.MagFilter == b.MagFilter && a.ClearInteger == b.ClearInteger;
+}
+
+void RenderGraph::ClearTarget(Resource &resource, uint32_t mask) const
+{
+  if (resource.Target == nullptr) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glClear(mask);
+    RenderStats::Add(RenderCounter::FRAMEBUFFER_BINDS);
+    RenderStats::Add(RenderCounter::CLEARS);
+    return;
+  }
+
+  // aliased resources share a framebuffer, each one still clears with its own color
+  resource.Target->SetClearColor(resource.Spec.ClearColor);
+  resource.Target->Bind();
+  resource.Target->Clear(mask);
+}
+
+void RenderGraph::DiscardTarget(Resource &resource, uint32_t mask) const
+{
+  if (resource.Target != nullptr) {
+    resource.Target->Discard(mask);
+    return;
+  }
+
+  std::vector<GLenum> attachments;
+  if (mask & AttachmentType::COLOR)
+    attachments.push_back(GL_COLOR);
+  if (mask & AttachmentType::DEPTH)
+    attachments.push_back(GL_DEPTH);
+  if (mask & AttachmentType::STENCIL)
+    attachments.push_back(GL_STENCIL);
+  glInvalidateNamedFramebufferData(0, (GLsizei)attachments.size(), attachments.data());
+}
+
+}  // namespace Ham
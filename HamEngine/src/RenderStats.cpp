@@ -0,0 +1,84 @@
+#include "Ham/Debug/RenderStats.h"
+
+#include <algorithm>
+
+namespace Ham {
+
+std::array<std::atomic_uint64_t, (size_t)RenderCounter::COUNT> RenderStats::s_Current = {};
+RenderStatsFrame RenderStats::s_LastFrame;
+std::array<RenderStatsFrame, RenderStats::HistorySize> RenderStats::s_History;
+uint32_t RenderStats::s_HistoryIndex = 0;
+uint32_t RenderStats::s_HistoryCount = 0;
+uint64_t RenderStats::s_FrameCount = 0;
+
+void RenderStats::EndFrame()
+{
+  for (size_t i = 0; i < s_Current.size(); i++)
+    s_LastFrame.Values[i] = s_Current[i].exchange(0, std::memory_order_relaxed);
+
+  s_History[s_HistoryIndex] = s_LastFrame;
+  s_HistoryIndex = (s_HistoryIndex + 1) % HistorySize;
+  s_HistoryCount = std::min(s_HistoryCount + 1, HistorySize);
+  s_FrameCount++;
+}
+
+RenderStatsFrame RenderStats::GetAverage()
+{
+  RenderStatsFrame average;
+  if (s_HistoryCount == 0)
+    return average;
+
+  for (uint32_t frame = 0; frame < s_HistoryCount; frame++)
+    for (size_t i = 0; i < average.Values.size(); i++)
+      average.Values[i] += s_History[frame].Values[i];
+  for (auto &value : average.Values)
+    value /= s_HistoryCount;
+  return average;
+}
+
+RenderStatsFrame RenderStats::GetMax()
+{
+  RenderStatsFrame max;
+  for (uint32_t frame = 0; frame < s_HistoryCount; frame++)
+    for (size_t i = 0; i < max.Values.size(); i++)
+      max.Values[i] = std::max(max.Values[i], s_History[frame].Values[i]);
+  return max;
+}
+
+void RenderStats::GetHistory(RenderCounter counter, std::vector<float> &values)
+{
+  values.resize(s_HistoryCount);
+  uint32_t first = (s_HistoryIndex + HistorySize - s_HistoryCount) % HistorySize;
+  for (uint32_t i = 0; i < s_HistoryCount; i++)
+    values[i] = (float)s_History[(first + i) % HistorySize][counter];
+}
+
+const char *RenderStats::GetName(RenderCounter counter)
+{
+  switch (counter) {
+    case RenderCounter::DRAW_CALLS:
+      return "Draw Calls";
+    case RenderCounter::TRIANGLES:
+      return "Triangles";
+    case RenderCounter::PROGRAM_BINDS:
+      return "Program Binds";
+    case RenderCounter::UNIFORM_UPDATES:
+      return "Uniform Updates";
+    case RenderCounter::VERTEX_ARRAY_BINDS:
+      return "Vertex Array Binds";
+    case RenderCounter::STATE_CHANGES:
+      return "State Changes";
+    case RenderCounter::FRAMEBUFFER_BINDS:
+      return "Framebuffer Binds";
+    case RenderCounter::CLEARS:
+      return "Clears";
+    case RenderCounter::BUFFER_UPLOADS:
+      return "Buffer Uploads";
+    case RenderCounter::UPLOAD_BYTES:
+      return "Upload Bytes";
+    default:
+      return "Unknown";
+  }
+}
+
+}  // namespace Ham
@@ -0,0 +1,73 @@
+#include "Ham/Renderer/RenderTargetPool.h"
+
+#include "Ham/Core/Base.h"
+
+#include <algorithm>
+
+namespace Ham {
+
+FrameBuffer *RenderTargetPool::Acquire(const FrameBufferSpecification &spec)
+{
+  HAM_CORE_ASSERT(spec.Width > 0 && spec.Height > 0, "Render target size must not be zero!");
+
+  // the smallest free target that fits wastes the least memory
+  Entry *best = nullptr;
+  for (auto &entry : m_Entries) {
+    if (entry.Borrowed || !IsCompatible(entry.Target->GetSpecification(), spec) || !entry.Target->Fits(spec.Width, spec.Height))
+      continue;
+
+    uint64_t area = (uint64_t)entry.Target->GetAllocatedWidth() * entry.Target->GetAllocatedHeight();
+    if (best == nullptr || area < (uint64_t)best->Target->GetAllocatedWidth() * best->Target->GetAllocatedHeight())
+      best = &entry;
+  }
+
+  if (best == nullptr) {
+    // allocated at the size class so the next frames can reuse it while the size moves a little
+    FrameBufferSpecification allocation = spec;
+    allocation.Width = (spec.Width + FrameBuffer::SizeClass - 1) / FrameBuffer::SizeClass * FrameBuffer::SizeClass;
+    allocation.Height = (spec.Height + FrameBuffer::SizeClass - 1) / FrameBuffer::SizeClass * FrameBuffer::SizeClass;
+
+    m_Entries.push_back({std::make_unique<FrameBuffer>(allocation)});
+    m_Allocations++;
+    best = &m_Entries.back();
+  }
+
+  best->Borrowed = true;
+  best->LastUsedFrame = m_Frame;
+  best->Target->Resize(spec.Width, spec.Height);
+  best->Target->SetClearColor(spec.ClearColor);
+  return best->Target.get();
+}
+
+void RenderTargetPool::Release(FrameBuffer *target)
+{
+  auto entry = std::find_if(m_Entries.begin(), m_Entries.end(), [target](const Entry &entry) { return entry.Target.get() == target; });
+  HAM_CORE_ASSERT(entry != m_Entries.end() && entry->Borrowed, "Render target was not borrowed from this pool!");
+  entry->Borrowed = false;
+}
+
+void RenderTargetPool::EndFrame()
+{
+  for (auto &entry : m_Entries)
+    entry.Borrowed = false;
+
+  m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(), [this](const Entry &entry) { return m_Frame - entry.LastUsedFrame > MaxIdleFrames; }), m_Entries.end());
+  m_Frame++;
+}
+
+void RenderTargetPool::Clear()
+{
+  m_Entries.clear();
+}
+
+uint32_t RenderTargetPool::GetBorrowedCount() const
+{
+  return (uint32_t)std::count_if(m_Entries.begin(), m_Entries.end(), [](const Entry &entry) { return entry.Borrowed; });
+}
+
+bool RenderTargetPool::IsCompatible(const FrameBufferSpecification &a, const FrameBufferSpecification &b)
+{
+  return a.ColorAttachments == b.ColorAttachments && a.ClearInteger == b.ClearInteger && a.DepthAttachment == b.DepthAttachment && a.Samples == b.Samples && a.MinFilter == b.MinFilter && a.MagFilter == b.MagFilter;
+}
+
+}  // namespace Ham
@@ -0,0 +1,143 @@
+#include "Ham/Renderer/RingBuffer.h"
+
+#include "Ham/Core/Base.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Ham {
+
+void RingBuffer::Init(uint32_t target, size_t frameSize)
+{
+  HAM_CORE_ASSERT(!m_isInitialized, "RingBuffer already initialized!");
+  m_Target = target;
+
+  // every allocation may end up bound as a uniform or storage block, so honour the stricter offset alignment
+  GLint uniformAlignment = 0, storageAlignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+  m_Alignment = (size_t)std::max({uniformAlignment, storageAlignment, 16});
+
+  Create(frameSize);
+  m_isInitialized = true;
+}
+
+void RingBuffer::Destroy()
+{
+  for (auto &fence : m_Fences) {
+    if (fence != nullptr)
+      glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  if (m_BufferID != 0) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_BufferID);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &m_BufferID);
+  }
+
+  m_BufferID = 0;
+  m_Mapped = nullptr;
+  m_isInitialized = false;
+}
+
+void RingBuffer::BeginFrame()
+{
+  HAM_CORE_ASSERT(m_isInitialized, "RingBuffer not initialized!");
+
+  if (m_Overflow > 0) {
+    // last frame didn't fit, wait for everything in flight and reallocate bigger storage
+    size_t frameSize = std::max(m_FrameSize * 2, m_FrameSize + m_Overflow);
+    HAM_CORE_WARN("RingBuffer frame overflowed by {0} bytes, growing from {1} to {2} bytes per frame", m_Overflow, m_FrameSize, frameSize);
+    for (uint32_t section = 0; section < FrameCount; section++)
+      WaitForSection(section);
+
+    uint32_t target = m_Target;
+    Destroy();
+    Create(frameSize);
+    m_Target = target;
+    m_isInitialized = true;
+    m_Overflow = 0;
+  }
+
+  m_Section = (m_Section + 1) % FrameCount;
+  m_Head = 0;
+  WaitForSection(m_Section);
+}
+
+void RingBuffer::EndFrame()
+{
+  HAM_CORE_ASSERT(m_Fences[m_Section] == nullptr, "RingBuffer::EndFrame called twice in one frame!");
+  m_Fences[m_Section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void *RingBuffer::Allocate(size_t size, size_t &offset)
+{
+  size_t aligned = (m_Head + m_Alignment - 1) & ~(m_Alignment - 1);
+  if (aligned + size > m_FrameSize) {
+    m_Overflow += size;
+    return nullptr;
+  }
+
+  m_Head = aligned + size;
+  offset = m_Section * m_FrameSize + aligned;
+  return m_Mapped + offset;
+}
+
+void RingBuffer::ResetWaitStats()
+{
+  m_LastWaitTime = 0.0f;
+  m_MaxWaitTime = 0.0f;
+  m_TotalWaitTime = 0.0f;
+  m_StallCount = 0;
+}
+
+void RingBuffer::Create(size_t frameSize)
+{
+  m_FrameSize = (frameSize + m_Alignment - 1) & ~(m_Alignment - 1);
+  m_Head = 0;
+  m_Section = 0;
+
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  // created through the copy target so the caller's bindings (e.g. a VAO's element buffer) stay untouched
+  glGenBuffers(1, &m_BufferID);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_BufferID);
+  glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(m_FrameSize * FrameCount), nullptr, flags);
+  m_Mapped = (uint8_t *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)(m_FrameSize * FrameCount), flags);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  HAM_CORE_ASSERT(m_Mapped != nullptr, "Failed to persistently map RingBuffer!");
+}
+
+void RingBuffer::WaitForSection(uint32_t section)
+{
+  GLsync &fence = m_Fences[section];
+  if (fence == nullptr)
+    return;
+
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  if (result == GL_TIMEOUT_EXPIRED) {
+    auto start = std::chrono::high_resolution_clock::now();
+    do {
+      result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1ms
+    } while (result == GL_TIMEOUT_EXPIRED);
+
+    m_LastWaitTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    m_MaxWaitTime = std::max(m_MaxWaitTime, m_LastWaitTime);
+    m_TotalWaitTime += m_LastWaitTime;
+    m_StallCount++;
+  }
+  else {
+    m_LastWaitTime = 0.0f;
+  }
+
+  if (result == GL_WAIT_FAILED)
+    HAM_CORE_ERROR("RingBuffer fence wait failed");
+
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+}  // namespace Ham
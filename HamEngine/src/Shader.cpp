@@ -1,52 +1,48 @@
 #include "Ham/Renderer/Shader.h"
 
 #include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+#include "Ham/Debug/RenderStats.h"
+#include "Ham/Renderer/ShaderPreprocessor.h"
 #include "Ham/Util/Watcher.h"
 
 #include <glad/gl.h>
 
-#define MESSAGE_SIZE 1024
-
 namespace Ham {
 
 std::vector<Shader *> Shader::s_Shaders;
+std::mutex Shader::s_ShadersMutex;
+std::atomic_uint32_t Shader::s_NextHandle = 1;
 
-Shader::Shader(std::string vertexPath, std::string fragmentPath, std::string geometryPath)
+Shader::Shader(std::string vertexPath, std::string fragmentPath, std::string geometryPath, std::vector<std::string> defines)
 {
   m_VertexSourcePath = vertexPath;
   m_FragmentSourcePath = fragmentPath;
   m_GeometrySourcePath = geometryPath;
+  m_Defines = std::move(defines);
+  m_Handle = s_NextHandle++;
   m_LastReloadTime = std::chrono::system_clock::now();
 
-  auto onFileChanged = [this]() {
-    Reload();
-  };
-  FileWatcher::Watch(m_VertexSourcePath, onFileChanged);
-  FileWatcher::Watch(m_FragmentSourcePath, onFileChanged);
-  if (!m_GeometrySourcePath.empty())
-    FileWatcher::Watch(m_GeometrySourcePath, onFileChanged);
-
-  m_RendererID = CreateShader(File::Read(m_VertexSourcePath), File::Read(m_FragmentSourcePath), File::Read(m_GeometrySourcePath));
-
-  if (m_RendererID == 0)
-    HAM_CORE_ERROR("Shader compilation failed");
-  else
-    Shader::s_Shaders.push_back(this);
+  std::lock_guard<std::mutex> lock(s_ShadersMutex);
+  Shader::s_Shaders.push_back(this);
 }
 
 Shader::~Shader()
 {
-  FileWatcher::Unwatch(m_VertexSourcePath);
-  FileWatcher::Unwatch(m_FragmentSourcePath);
-  if (!m_GeometrySourcePath.empty())
-    FileWatcher::Unwatch(m_GeometrySourcePath);
+  {
+    std::lock_guard<std::mutex> lock(s_ShadersMutex);
+    Shader::s_Shaders.erase(std::find(Shader::s_Shaders.begin(), Shader::s_Shaders.end(), this));
+  }
+  WatchDependencies({});
 
-  Shader::s_Shaders.erase(std::find(Shader::s_Shaders.begin(), Shader::s_Shaders.end(), this));
+  if (m_Compile != nullptr && ShaderCompiler::Wait(*m_Compile) == ShaderCompileStatus::DONE)
+    glDeleteProgram(m_Compile->Program);
   glDeleteProgram(m_RendererID);
 }
 
 void Shader::Bind() const
 {
+  RenderStats::Add(RenderCounter::PROGRAM_BINDS);
   glUseProgram(m_RendererID);
 }
 
@@ -66,149 +62,165 @@ void Shader::Reload()
 
 void Shader::PerformReload()
 {
-  if (!m_ShouldReload)
+  // a reload requested while the previous one is still compiling waits for it to finish
+  if (m_ShouldReload && m_Compile == nullptr) {
+    m_ShouldReload = false;
+    SubmitCompile();
+  }
+
+  if (m_Compile != nullptr && ShaderCompiler::Poll(*m_Compile) != ShaderCompileStatus::PENDING)
+    ApplyCompile();
+}
+
+void Shader::PerformReloads(bool wait)
+{
+  std::lock_guard<std::mutex> lock(s_ShadersMutex);
+  for (auto shader : s_Shaders) {
+    if (wait)
+      shader->WaitUntilReady();
+    else
+      shader->PerformReload();
+  }
+}
+
+void Shader::WaitUntilReady()
+{
+  if (m_ShouldReload && m_Compile == nullptr) {
+    m_ShouldReload = false;
+    SubmitCompile();
+  }
+
+  if (m_Compile == nullptr)
     return;
-  m_ShouldReload = false;
 
-  m_UniformLocationCache.clear();
-  auto newProgram = CreateShader(File::Read(m_VertexSourcePath), File::Read(m_FragmentSourcePath), File::Read(m_GeometrySourcePath));
-  if (newProgram == 0) {
-    HAM_CORE_ERROR("Shader recompilation failed:\n\t{0}\n\t{1}", m_VertexSourcePath, m_FragmentSourcePath);
+  ShaderCompiler::Wait(*m_Compile);
+  ApplyCompile();
+}
+
+void Shader::SubmitCompile()
+{
+  HAM_PROFILE_SCOPE();
+
+  const std::string *paths[3] = {&m_VertexSourcePath, &m_FragmentSourcePath, &m_GeometrySourcePath};
+  std::string sources[3];
+  std::vector<std::string> dependencies;
+
+  bool processed = true;
+  for (int stage = 0; stage < 3; stage++) {
+    if (!paths[stage]->empty())
+      processed = ShaderPreprocessor::Process(*paths[stage], m_Defines, sources[stage], dependencies) && processed;
+  }
+
+  // watched even when preprocessing failed, fixing the broken file triggers the next attempt
+  WatchDependencies(dependencies);
+  if (!processed) {
+    HAM_CORE_ERROR("Shader preprocessing failed: {0}", GetDescription());
     return;
   }
+
+  m_Compile = ShaderCompiler::Submit(sources[0], sources[1], sources[2]);
+}
+
+void Shader::ApplyCompile()
+{
+  auto compile = std::move(m_Compile);
+  if (compile->Status != ShaderCompileStatus::DONE) {
+    HAM_CORE_ERROR("Shader compilation failed: {0}", GetDescription());
+    for (size_t i = 0; i < m_Dependencies.size(); i++)
+      HAM_CORE_ERROR("\tsource {0}: {1}", i, m_Dependencies[i]);
+    return;
+  }
+
+  // swapped between frames, so every draw sees either the old or the new program
   glDeleteProgram(m_RendererID);
-  m_RendererID = newProgram;
-  // HAM_CORE_INFO("Reloaded shader:\n\t{0}\n\t{1}", m_VertexSourcePath, m_FragmentSourcePath);
+  m_RendererID = compile->Program;
+  m_UniformLocationCache.clear();
+}
+
+void Shader::WatchDependencies(const std::vector<std::string> &dependencies)
+{
+  if (dependencies == m_Dependencies)
+    return;
+
+  for (size_t i = 0; i < m_Dependencies.size(); i++)
+    FileWatcher::Unwatch(m_Dependencies[i], m_WatchIDs[i]);
+
+  m_Dependencies = dependencies;
+  m_WatchIDs.clear();
+  for (auto &dependency : m_Dependencies)
+    m_WatchIDs.push_back(FileWatcher::Watch(dependency, [this]() { Reload(); }));
+}
+
+std::string Shader::GetDescription() const
+{
+  std::string description = m_VertexSourcePath + ", " + m_FragmentSourcePath;
+  if (!m_GeometrySourcePath.empty())
+    description += ", " + m_GeometrySourcePath;
+  for (auto &define : m_Defines)
+    description += " -D" + define;
+  return description;
 }
 
 void Shader::SetUniform1i(const std::string &name, int value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform1i(GetUniformLocation(name), value);
 }
 
 void Shader::SetUniform2i(const std::string &name, math::ivec2 value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform2i(GetUniformLocation(name), value.x, value.y);
 }
 
 void Shader::SetUniform3i(const std::string &name, math::ivec3 value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform3i(GetUniformLocation(name), value.x, value.y, value.z);
 }
 
 void Shader::SetUniform4i(const std::string &name, math::ivec4 value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform4i(GetUniformLocation(name), value.x, value.y, value.z, value.w);
 }
 
 void Shader::SetUniform1f(const std::string &name, float value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform1f(GetUniformLocation(name), value);
 }
 
 void Shader::SetUniform2f(const std::string &name, math::vec2 value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform2f(GetUniformLocation(name), value.x, value.y);
 }
 
 void Shader::SetUniform3f(const std::string &name, math::vec3 value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform3f(GetUniformLocation(name), value.x, value.y, value.z);
 }
 
 void Shader::SetUniform4f(const std::string &name, math::vec4 value)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w);
 }
 
 void Shader::SetUniformMat3f(const std::string &name, const math::mat3 &matrix)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, matrix.stripes.data()->data());
 }
 
 void Shader::SetUniformMat4f(const std::string &name, const math::mat4 &matrix)
 {
+  RenderStats::Add(RenderCounter::UNIFORM_UPDATES);
   glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, matrix.stripes.data()->data());
 }
 
-unsigned int Shader::CompileShader(unsigned int type, const std::string &source)
-{
-  std::string shaderType;
-  switch (type) {
-      // clang-format off
-            case GL_VERTEX_SHADER: shaderType = "vertex"; break; 
-            case GL_FRAGMENT_SHADER: shaderType = "fragment"; break;
-            case GL_GEOMETRY_SHADER: shaderType = "geometry"; break;
-            default: shaderType = "unknown"; break;
-      // clang-format on
-  }
-
-  unsigned int id = glCreateShader(type);
-  const char *src = source.c_str();
-  glShaderSource(id, 1, &src, nullptr);
-  glCompileShader(id);
-
-  // Error handling
-  int result = -1;
-  glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-  if (result != GL_TRUE) {
-    char message[MESSAGE_SIZE];
-    glGetShaderInfoLog(id, MESSAGE_SIZE, nullptr, message);
-
-    HAM_CORE_ERROR("Failed to compile {0} shader!", shaderType);
-    HAM_CORE_ERROR("OpenGL Error: {0}", message);
-    glDeleteShader(id);
-    return 0;
-  }
-
-  return id;
-}
-
-unsigned int Shader::CreateShader(const std::string &vertexShader, const std::string &fragmentShader, const std::string &geometryShader)
-{
-  auto program = glCreateProgram();
-  unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-  unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
-  unsigned int gs = 0;
-  if (!geometryShader.empty())
-    gs = CompileShader(GL_GEOMETRY_SHADER, geometryShader);
-
-  if (vs == 0 || fs == 0 || (gs == 0 && !geometryShader.empty())) {
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    glDeleteShader(gs);
-    return program;
-  }
-
-  glAttachShader(program, vs);
-  glAttachShader(program, fs);
-  if (!geometryShader.empty())
-    glAttachShader(program, gs);
-  glLinkProgram(program);
-  glValidateProgram(program);
-
-  // Error handling
-  int result = -1;
-  glGetProgramiv(program, GL_LINK_STATUS, &result);
-  if (result != GL_TRUE) {
-    char message[MESSAGE_SIZE];
-    glGetProgramInfoLog(program, MESSAGE_SIZE, nullptr, message);
-
-    HAM_CORE_ERROR("Failed to link shader program!");
-    HAM_CORE_ERROR("{0}", message);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    glDeleteShader(gs);
-    return 0;
-  }
-
-  glDeleteShader(vs);
-  glDeleteShader(fs);
-  glDeleteShader(gs);
-
-  return program;
-}
-
 int Shader::GetUniformLocation(const std::string &name)
 {
   if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
@@ -0,0 +1,153 @@
+#include "Ham/Renderer/ShaderCache.h"
+
+#include "Ham/Core/Base.h"
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace Ham {
+
+struct ShaderCacheHeader {
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t Format;
+  uint32_t Length;
+};
+
+static constexpr uint32_t s_CacheMagic = 0x534D4148;  // "HAMS"
+static constexpr uint32_t s_CacheVersion = 1;
+
+std::string ShaderCache::s_Directory;
+std::string ShaderCache::s_Driver;
+bool ShaderCache::s_Enabled = false;
+uint32_t ShaderCache::s_Hits = 0;
+uint32_t ShaderCache::s_Misses = 0;
+
+void ShaderCache::Init(const std::string &directory)
+{
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (formats == 0) {
+    HAM_CORE_WARN("Driver supports no program binary formats, shader cache disabled");
+    return;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    HAM_CORE_WARN("Could not create shader cache directory {0}: {1}", directory, error.message());
+    return;
+  }
+
+  s_Directory = directory;
+  s_Driver = std::string((const char *)glGetString(GL_VENDOR)) + '\n' + (const char *)glGetString(GL_RENDERER) + '\n' + (const char *)glGetString(GL_VERSION);
+  s_Enabled = true;
+}
+
+uint64_t ShaderCache::GetKey(const std::vector<std::string> &sources)
+{
+  // FNV-1a, stages are separated by a zero byte so moving text between stages changes the key
+  uint64_t hash = 14695981039346656037ull;
+  auto feed = [&hash](const std::string &text) {
+    for (unsigned char c : text) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    hash *= 1099511628211ull;  // the zero byte
+  };
+
+  feed(s_Driver);
+  for (auto &source : sources)
+    feed(source);
+  return hash;
+}
+
+unsigned int ShaderCache::Load(uint64_t key)
+{
+  if (!s_Enabled)
+    return 0;
+
+  auto path = GetPath(key);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    s_Misses++;
+    return 0;
+  }
+
+  ShaderCacheHeader header;
+  std::vector<char> binary;
+  if (file.read((char *)&header, sizeof(header)) && header.Magic == s_CacheMagic && header.Version == s_CacheVersion && header.Key == key) {
+    binary.resize(header.Length);
+    file.read(binary.data(), header.Length);
+  }
+  bool valid = !binary.empty() && file.gcount() == (std::streamsize)header.Length;
+  file.close();
+
+  unsigned int program = 0;
+  if (valid) {
+    program = glCreateProgram();
+    glProgramBinary(program, header.Format, binary.data(), (GLsizei)binary.size());
+
+    int result = -1;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result != GL_TRUE) {  // the driver may reject binaries at any time, e.g. after an update
+      glDeleteProgram(program);
+      program = 0;
+    }
+  }
+
+  if (program == 0) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    s_Misses++;
+    return 0;
+  }
+
+  s_Hits++;
+  return program;
+}
+
+void ShaderCache::Store(uint64_t key, unsigned int program)
+{
+  if (!s_Enabled)
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  ShaderCacheHeader header = {s_CacheMagic, s_CacheVersion, key, format, (uint32_t)length};
+
+  // written to a temporary file first so a crash never leaves a truncated entry behind
+  auto path = GetPath(key);
+  {
+    std::ofstream file(path + ".tmp", std::ios::binary);
+    file.write((const char *)&header, sizeof(header));
+    file.write(binary.data(), length);
+    if (!file) {
+      HAM_CORE_WARN("Could not write shader cache entry {0}", path);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(path + ".tmp", path, error);
+}
+
+std::string ShaderCache::GetPath(uint64_t key)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return (std::filesystem::path(s_Directory) / name).string();
+}
+
+}  // namespace Ham
@@ -0,0 +1,217 @@
+#include "Ham/Renderer/ShaderCompiler.h"
+
+#include "Ham/Core/Base.h"
+#include "Ham/Debug/Profiler.h"
+#include "Ham/Renderer/ShaderCache.h"
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#define MESSAGE_SIZE 1024
+
+namespace Ham {
+
+static constexpr unsigned int s_StageTypes[3] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER};
+static constexpr const char *s_StageNames[3] = {"vertex", "fragment", "geometry"};
+
+bool ShaderCompiler::s_DriverParallel = false;
+std::thread ShaderCompiler::s_Worker;
+std::deque<std::shared_ptr<ShaderCompileJob>> ShaderCompiler::s_Queue;
+std::mutex ShaderCompiler::s_Mutex;
+std::condition_variable ShaderCompiler::s_QueueCondition;
+std::condition_variable ShaderCompiler::s_DoneCondition;
+bool ShaderCompiler::s_Stopping = false;
+
+void ShaderCompiler::Init(GLFWwindow *sharedContext)
+{
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);  // let the driver pick
+    s_DriverParallel = true;
+  }
+  else if (GLAD_GL_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    s_DriverParallel = true;
+  }
+  else if (sharedContext != nullptr) {
+    s_Stopping = false;
+    s_Worker = std::thread(&ShaderCompiler::WorkerMain, sharedContext);
+  }
+
+  HAM_CORE_INFO("Shader compilation: {0}", s_DriverParallel ? "driver threads" : HasWorker() ? "shared context worker" : "deferred status queries");
+}
+
+void ShaderCompiler::Shutdown()
+{
+  if (!s_Worker.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Stopping = true;
+  }
+  s_QueueCondition.notify_all();
+  s_Worker.join();
+
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  for (auto &job : s_Queue)
+    job->Status = ShaderCompileStatus::FAILED;
+  s_Queue.clear();
+  s_DoneCondition.notify_all();
+}
+
+std::shared_ptr<ShaderCompileJob> ShaderCompiler::Submit(const std::string &vertex, const std::string &fragment, const std::string &geometry)
+{
+  auto job = std::make_shared<ShaderCompileJob>();
+  job->Sources[0] = vertex;
+  job->Sources[1] = fragment;
+  job->Sources[2] = geometry;
+  job->CacheKey = ShaderCache::GetKey({vertex, fragment, geometry});
+
+  // cached binaries load fast enough to do right here
+  job->Program = ShaderCache::Load(job->CacheKey);
+  if (job->Program != 0) {
+    job->Status = ShaderCompileStatus::DONE;
+    return job;
+  }
+
+  if (HasWorker()) {
+    {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      s_Queue.push_back(job);
+    }
+    s_QueueCondition.notify_one();
+  }
+  else {
+    StartCompile(*job);
+  }
+
+  return job;
+}
+
+ShaderCompileStatus ShaderCompiler::Poll(ShaderCompileJob &job)
+{
+  if (job.Status != ShaderCompileStatus::PENDING || HasWorker())
+    return job.Status;
+
+  if (s_DriverParallel) {
+    int complete = GL_FALSE;
+    glGetProgramiv(job.Program, GL_COMPLETION_STATUS_KHR, &complete);
+    if (complete != GL_TRUE)
+      return ShaderCompileStatus::PENDING;
+  }
+
+  job.Status = FinishCompile(job) ? ShaderCompileStatus::DONE : ShaderCompileStatus::FAILED;
+  return job.Status;
+}
+
+ShaderCompileStatus ShaderCompiler::Wait(ShaderCompileJob &job)
+{
+  if (HasWorker()) {
+    std::unique_lock<std::mutex> lock(s_Mutex);
+    s_DoneCondition.wait(lock, [&job]() { return job.Status != ShaderCompileStatus::PENDING; });
+    return job.Status;
+  }
+
+  if (job.Status == ShaderCompileStatus::PENDING)  // the status queries block until the driver is done
+    job.Status = FinishCompile(job) ? ShaderCompileStatus::DONE : ShaderCompileStatus::FAILED;
+  return job.Status;
+}
+
+void ShaderCompiler::StartCompile(ShaderCompileJob &job)
+{
+  // no status queries here, they would wait for each stage in turn
+  job.Program = glCreateProgram();
+  glProgramParameteri(job.Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+  for (int stage = 0; stage < 3; stage++) {
+    if (job.Sources[stage].empty())
+      continue;
+
+    const char *source = job.Sources[stage].c_str();
+    job.Stages[stage] = glCreateShader(s_StageTypes[stage]);
+    glShaderSource(job.Stages[stage], 1, &source, nullptr);
+    glCompileShader(job.Stages[stage]);
+    glAttachShader(job.Program, job.Stages[stage]);
+  }
+
+  glLinkProgram(job.Program);
+}
+
+bool ShaderCompiler::FinishCompile(ShaderCompileJob &job)
+{
+  bool compiled = true;
+  for (int stage = 0; stage < 3; stage++) {
+    if (job.Stages[stage] == 0)
+      continue;
+
+    int result = -1;
+    glGetShaderiv(job.Stages[stage], GL_COMPILE_STATUS, &result);
+    if (result != GL_TRUE) {
+      char message[MESSAGE_SIZE];
+      glGetShaderInfoLog(job.Stages[stage], MESSAGE_SIZE, nullptr, message);
+
+      HAM_CORE_ERROR("Failed to compile {0} shader!", s_StageNames[stage]);
+      HAM_CORE_ERROR("OpenGL Error: {0}", message);
+      compiled = false;
+    }
+  }
+
+  int result = -1;
+  glGetProgramiv(job.Program, GL_LINK_STATUS, &result);
+  if (compiled && result != GL_TRUE) {
+    char message[MESSAGE_SIZE];
+    glGetProgramInfoLog(job.Program, MESSAGE_SIZE, nullptr, message);
+
+    HAM_CORE_ERROR("Failed to link shader program!");
+    HAM_CORE_ERROR("{0}", message);
+  }
+
+  for (auto &stage : job.Stages) {
+    if (stage == 0)
+      continue;
+    glDetachShader(job.Program, stage);
+    glDeleteShader(stage);
+    stage = 0;
+  }
+
+  if (!compiled || result != GL_TRUE) {
+    glDeleteProgram(job.Program);
+    job.Program = 0;
+    return false;
+  }
+
+  ShaderCache::Store(job.CacheKey, job.Program);
+  return true;
+}
+
+void ShaderCompiler::WorkerMain(GLFWwindow *context)
+{
+  HAM_PROFILE_THREAD("Shader Compiler");
+  glfwMakeContextCurrent(context);
+
+  while (true) {
+    std::shared_ptr<ShaderCompileJob> job;
+    {
+      std::unique_lock<std::mutex> lock(s_Mutex);
+      s_QueueCondition.wait(lock, []() { return s_Stopping || !s_Queue.empty(); });
+      if (s_Stopping)
+        break;
+      job = s_Queue.front();
+      s_Queue.pop_front();
+    }
+
+    StartCompile(*job);
+    bool linked = FinishCompile(*job);
+    glFinish();  // the program must be complete before another context uses it
+
+    {
+      std::lock_guard<std::mutex> lock(s_Mutex);
+      job->Status = linked ? ShaderCompileStatus::DONE : ShaderCompileStatus::FAILED;
+    }
+    s_DoneCondition.notify_all();
+  }
+
+  glfwMakeContextCurrent(nullptr);
+}
+
+}  // namespace Ham
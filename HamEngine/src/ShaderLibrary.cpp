@@ -1,37 +1,78 @@
 #include "Ham/Renderer/ShaderLibrary.h"
 #include "Ham/Core/FileSystem.h"
+#include "Ham/Renderer/ShaderCache.h"
 
 #include "fmt/format.h"
+#include <algorithm>
 #include <filesystem>
 
 namespace Ham {
-std::unordered_map<std::string, std::shared_ptr<Shader>> ShaderLibrary::s_Shaders;
+std::unordered_map<std::string, ShaderTemplate> ShaderLibrary::s_Templates;
+std::unordered_map<std::string, std::shared_ptr<Shader>> ShaderLibrary::s_Variants;
+std::mutex ShaderLibrary::s_Mutex;
 
 void ShaderLibrary::Init()
 {
-  ShaderLibrary::Load("face-normal", ASSETS_PATH_CORE "shaders/default.vert", ASSETS_PATH_CORE "shaders/default.frag");
-  ShaderLibrary::Load("outline", ASSETS_PATH_CORE "shaders/outline.vert", ASSETS_PATH_CORE "shaders/outline.frag");
-  ShaderLibrary::Load("vertex-normal", ASSETS_PATH_CORE "shaders/default.vert", ASSETS_PATH_CORE "shaders/flat.frag", ASSETS_PATH_CORE "shaders/normals.geom");
-  ShaderLibrary::Load("funk", ASSETS_PATH_CORE "shaders/default.vert", ASSETS_PATH_CORE "shaders/funk.frag");
-  ShaderLibrary::Load("object-picker", ASSETS_PATH_CORE "shaders/default.vert", ASSETS_PATH_CORE "shaders/object-picker.frag");
+  ShaderCache::Init((FileSystem::GetExecutableDir() / "shader-cache").string());
+
+  // INDIRECT variants are used by RENDER_MODE_MULTI_DRAW_INDIRECT
+  ShaderLibrary::Register("face-normal", {ASSETS_PATH_CORE "shaders/default.vert", ASSETS_PATH_CORE "shaders/default.frag", "", {}, {"INDIRECT", "WIREFRAME"}});
+  ShaderLibrary::Register("funk", {ASSETS_PATH_CORE "shaders/default.vert", ASSETS_PATH_CORE "shaders/default.frag", "", {"FUNK"}, {"INDIRECT", "WIREFRAME"}});
+  ShaderLibrary::Register("vertex-normal", {ASSETS_PATH_CORE "shaders/normals.vert", ASSETS_PATH_CORE "shaders/default.frag", "", {"FLAT_COLOR"}});
+  ShaderLibrary::Register("outline", {ASSETS_PATH_CORE "shaders/outline.vert", ASSETS_PATH_CORE "shaders/outline.frag"});
+  ShaderLibrary::Register("debug-lines", {ASSETS_PATH_CORE "shaders/debug.vert", ASSETS_PATH_CORE "shaders/debug.frag"});
+  ShaderLibrary::Register("particles", {ASSETS_PATH_CORE "shaders/particles.vert", ASSETS_PATH_CORE "shaders/particles.frag"});
+}
+
+void ShaderLibrary::Register(std::string name, ShaderTemplate shaderTemplate)
+{
+  HAM_CORE_ASSERT(std::filesystem::exists(shaderTemplate.VertexPath), fmt::format("Cannot find vertex shader: {0}", shaderTemplate.VertexPath));
+  HAM_CORE_ASSERT(std::filesystem::exists(shaderTemplate.FragmentPath), fmt::format("Cannot find fragment shader: {0}", shaderTemplate.FragmentPath));
+  if (shaderTemplate.GeometryPath != "")
+    HAM_CORE_ASSERT(std::filesystem::exists(shaderTemplate.GeometryPath), "Geometry shader path is invalid");
+
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  HAM_CORE_ASSERT(s_Templates.find(name) == s_Templates.end(), "Shader already exists");
+  s_Templates[name] = std::move(shaderTemplate);
 }
 
 std::shared_ptr<Shader> ShaderLibrary::Load(std::string name, std::string vertexPath, std::string fragmentPath, std::string geometryPath)
 {
-  HAM_CORE_ASSERT(s_Shaders.find(name) == s_Shaders.end(), "Shader already exists");
-  HAM_CORE_ASSERT(std::filesystem::exists(vertexPath), fmt::format("Cannot find vertex shader: {0}", vertexPath));
-  HAM_CORE_ASSERT(std::filesystem::exists(fragmentPath), fmt::format("Cannot find fragment shader: {0}", fragmentPath));
-  if (geometryPath != "")
-    HAM_CORE_ASSERT(std::filesystem::exists(geometryPath), "Geometry shader path is invalid");
-
-  s_Shaders[name] = std::make_shared<Shader>(vertexPath, fragmentPath, geometryPath);
-  return s_Shaders[name];
+  Register(name, {vertexPath, fragmentPath, geometryPath});
+  auto shader = Get(name);
+  shader->WaitUntilReady();
+  return shader;
 }
 
-std::shared_ptr<Shader> ShaderLibrary::Get(std::string name)
+std::shared_ptr<Shader> ShaderLibrary::Get(const std::string &name, std::vector<std::string> options)
 {
-  if (s_Shaders.find(name) == s_Shaders.end())
+  std::sort(options.begin(), options.end());
+  options.erase(std::unique(options.begin(), options.end()), options.end());
+
+  std::string key = name;
+  for (auto &option : options)
+    key += "|" + option;
+
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  auto variant = s_Variants.find(key);
+  if (variant != s_Variants.end())
+    return variant->second;
+
+  auto shaderTemplate = s_Templates.find(name);
+  if (shaderTemplate == s_Templates.end())
     return nullptr;
-  return s_Shaders[name];
+
+  auto &supported = shaderTemplate->second.Options;
+  for (auto &option : options) {
+    if (std::find(supported.begin(), supported.end(), option) == supported.end())
+      return nullptr;
+  }
+
+  auto defines = shaderTemplate->second.Defines;
+  defines.insert(defines.end(), options.begin(), options.end());
+
+  auto shader = std::make_shared<Shader>(shaderTemplate->second.VertexPath, shaderTemplate->second.FragmentPath, shaderTemplate->second.GeometryPath, defines);
+  s_Variants[key] = shader;
+  return shader;
 }
 }  // namespace Ham
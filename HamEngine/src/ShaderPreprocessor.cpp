@@ -0,0 +1,134 @@
+#include "Ham/Renderer/ShaderPreprocessor.h"
+
+#include "Ham/Core/Base.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace Ham {
+
+static constexpr int s_MaxIncludeDepth = 32;
+
+static std::string NormalizePath(const std::string &path)
+{
+  return std::filesystem::path(path).lexically_normal().make_preferred().string();
+}
+
+// returns the directive name of a preprocessor line ("include", "pragma", ...) and where its arguments start
+static std::string GetDirective(const std::string &line, size_t &arguments)
+{
+  size_t start = line.find_first_not_of(" \t");
+  if (start == std::string::npos || line[start] != '#')
+    return "";
+
+  start = line.find_first_not_of(" \t", start + 1);
+  if (start == std::string::npos)
+    return "";
+
+  size_t end = start;
+  while (end < line.size() && (std::isalnum((unsigned char)line[end]) || line[end] == '_'))
+    end++;
+
+  arguments = end;
+  return line.substr(start, end - start);
+}
+
+bool ShaderPreprocessor::Process(const std::string &path, const std::vector<std::string> &defines, std::string &output, std::vector<std::string> &dependencies)
+{
+  std::string defineBlock;
+  for (auto &define : defines) {
+    auto separator = define.find('=');
+    if (separator == std::string::npos)
+      defineBlock += "#define " + define + "\n";
+    else
+      defineBlock += "#define " + define.substr(0, separator) + " " + define.substr(separator + 1) + "\n";
+  }
+
+  output.clear();
+  std::vector<std::string> onceFiles;
+  return ProcessFile(path, output, dependencies, onceFiles, defineBlock, 0);
+}
+
+bool ShaderPreprocessor::ProcessFile(const std::string &path, std::string &output, std::vector<std::string> &dependencies, std::vector<std::string> &onceFiles, const std::string &defines, int depth)
+{
+  auto filePath = NormalizePath(path);
+  if (std::find(onceFiles.begin(), onceFiles.end(), filePath) != onceFiles.end())
+    return true;
+
+  auto found = std::find(dependencies.begin(), dependencies.end(), filePath);
+  int sourceIndex = (int)(found - dependencies.begin());
+  if (found == dependencies.end())
+    dependencies.push_back(filePath);
+
+  if (depth > s_MaxIncludeDepth) {
+    HAM_CORE_ERROR("Shader includes nested too deeply (include cycle?): {0}", filePath);
+    return false;
+  }
+
+  std::ifstream file(filePath);
+  if (!file) {
+    HAM_CORE_ERROR("Failed to open shader file: {0}", filePath);
+    return false;
+  }
+
+  // the root file's #version has to stay first, defines go right after it
+  bool needsDefines = depth == 0;
+  auto directory = std::filesystem::path(filePath).parent_path();
+
+  std::string line;
+  int lineNumber = 0;
+  if (!needsDefines)
+    output += "#line 1 " + std::to_string(sourceIndex) + "\n";
+
+  while (std::getline(file, line)) {
+    lineNumber++;
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    size_t arguments = 0;
+    auto directive = GetDirective(line, arguments);
+
+    if (directive == "version" && needsDefines) {
+      output += line + "\n" + defines;
+      output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+      needsDefines = false;
+      continue;
+    }
+
+    if (directive == "pragma" && line.find("once", arguments) != std::string::npos) {
+      onceFiles.push_back(filePath);
+      output += "\n";  // keeps the line count intact
+      continue;
+    }
+
+    if (directive == "include") {
+      size_t open = line.find_first_of("\"<", arguments);
+      size_t close = open == std::string::npos ? open : line.find_first_of("\">", open + 1);
+      if (close == std::string::npos) {
+        HAM_CORE_ERROR("{0}({1}): malformed #include", filePath, lineNumber);
+        return false;
+      }
+
+      auto includePath = (directory / line.substr(open + 1, close - open - 1)).string();
+      if (!ProcessFile(includePath, output, dependencies, onceFiles, defines, depth + 1)) {
+        HAM_CORE_ERROR("  included from {0}({1})", filePath, lineNumber);
+        return false;
+      }
+
+      output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+      continue;
+    }
+
+    output += line + "\n";
+  }
+
+  // no #version in the root file, the defines still have to be somewhere
+  if (needsDefines)
+    output = defines + "#line 1 " + std::to_string(sourceIndex) + "\n" + output;
+
+  return true;
+}
+
+}  // namespace Ham
@@ -1,11 +1,21 @@
 #include "Ham/Scene/Systems.h"
 
 #include "Ham/Core/Base.h"
+#include "Ham/Debug/DebugDraw.h"
+#include "Ham/Debug/RenderStats.h"
+#include "Ham/Renderer/DepthSorter.h"
 
 #include "Ham/Scene/Entity.h"
+#include "Ham/Scene/Heightfield.h"
+#include "Ham/Scene/Particles.h"
 #include "Ham/Scene/Scene.h"
+#include "Ham/Util/JobSystem.h"
 #include "Ham/Core/Base.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 namespace Ham {
 void Systems::AttachNativeScripts(Scene &scene)
 {
@@ -92,183 +102,870 @@ void Systems::UpdateNativeScriptsUI(Scene &scene, TimeStep &deltaTime)
   }
 }
 
-void Systems::RenderScene(Application &app, Scene &scene, TimeStep &deltaTime)
+// transpose(inverse(model)) for the upper 3x3, which is all the shaders use: the cofactors over the determinant,
+// three cross products instead of a full 4x4 inverse
+static math::mat4 GetNormalMatrix(const math::mat4 &model)
+{
+  math::vec3 x = {model(0, 0), model(1, 0), model(2, 0)};
+  math::vec3 y = {model(0, 1), model(1, 1), model(2, 1)};
+  math::vec3 z = {model(0, 2), model(1, 2), model(2, 2)};
+  math::vec3 cx = math::cross(y, z), cy = math::cross(z, x), cz = math::cross(x, y);
+  float determinant = math::dot(x, cx);
+  float scale = std::abs(determinant) > 1e-20f ? 1.0f / determinant : 0.0f;
+
+  math::mat4 normal = math::identity<math::mat4>();
+  for (int row = 0; row < 3; row++) {
+    normal(row, 0) = cx[row] * scale;
+    normal(row, 1) = cy[row] * scale;
+    normal(row, 2) = cz[row] * scale;
+  }
+  return normal;
+}
+
+uint32_t Systems::GetMeshState(const Component::Mesh &mesh)
 {
-  static auto lightPos = math::vec3(1.0f, 0.0f, 0.0f);
-  static auto lightColor = math::vec3(1.0f, 0.1f, 0.1f);
+  uint32_t state = RENDER_STATE_DEPTH_TEST;
+  if (mesh.BackfaceCulling)
+    state |= RENDER_STATE_CULL_BACK;
+  if (mesh.AlphaBlending)
+    state |= RENDER_STATE_ALPHA_BLEND;
+  if (mesh.ShowFill && mesh.ShowWireframe)
+    state |= RENDER_STATE_WIREFRAME_OVERLAY;
+  return state;
+}
+
+// Variants are requested from ShaderLibrary (which compiles them on first use) only when the flags need them
+void Systems::ResolveShaders(Component::ShaderList &shaders, uint32_t state, bool indirect)
+{
+  uint32_t key = state | (indirect ? 0x80000000u : 0u);
+  if (key == shaders.ResolvedKey && shaders.Resolved.size() == shaders.Names.size())
+    return;
+
+  bool overlay = (state & RENDER_STATE_WIREFRAME_OVERLAY) != 0;
+  shaders.Resolved.assign(shaders.Names.size(), {});
+  for (size_t i = 0; i < shaders.Names.size(); i++) {
+    auto &name = shaders.Names[i];
+    auto &resolved = shaders.Resolved[i];
+
+    resolved.Program = ShaderLibrary::Get(name);
+    resolved.DebugNormals = name == "vertex-normal";
+    if (overlay)
+      resolved.Overlay = ShaderLibrary::Get(name, {"WIREFRAME"});
+    if (indirect)
+      resolved.Indirect = ShaderLibrary::Get(name, {"INDIRECT"});
+    if (indirect && overlay)
+      resolved.IndirectOverlay = ShaderLibrary::Get(name, {"INDIRECT", "WIREFRAME"});
+
+    if (resolved.Program != nullptr) {
+      resolved.Fill = PipelineCache::Get(resolved.Program.get(), state);
+      resolved.Wireframe = PipelineCache::Get(resolved.Program.get(), state | RENDER_STATE_WIREFRAME);
+    }
+    if (resolved.Overlay != nullptr)
+      resolved.OverlayFill = PipelineCache::Get(resolved.Overlay.get(), state);
+    if (resolved.Indirect != nullptr) {
+      resolved.IndirectFill = PipelineCache::Get(resolved.Indirect.get(), state);
+      resolved.IndirectWireframe = PipelineCache::Get(resolved.Indirect.get(), state | RENDER_STATE_WIREFRAME);
+    }
+    if (resolved.IndirectOverlay != nullptr)
+      resolved.IndirectOverlayFill = PipelineCache::Get(resolved.IndirectOverlay.get(), state);
+  }
+  shaders.ResolvedKey = key;
+}
+
+// Only reads the mesh and the resolved shader, safe on worker threads
+void Systems::RecordMesh(RenderCommandList &list, const Component::Mesh &mesh, const math::mat4 &model, const math::mat4 &normal, const Component::ResolvedShader &shader, int id)
+{
+  if (shader.Program == nullptr)  // TODO: Use default shader instead
+    return;
+
+  if (!shader.Program->IsReady())  // variant requested for the first time, compiled by the render thread at the end of the frame
+    return;
+
+  uint32_t indexCount = (uint32_t)mesh.Indices.Size();
 
+  // debug normals: one line per vertex, expanded by normals.vert from the vertex buffer bound as storage buffer 1
+  if (shader.DebugNormals) {
+    list.BindPipeline(shader.Fill);
+    list.BindVertexArray(mesh.VAO.get(), mesh.Vertices.GetID(), mesh.Indices.GetID());  // core profile needs one bound
+    list.BindStorageBuffer(1, mesh.Vertices.GetID());
+    list.SetObjectData({model, normal, id, 0});
+    list.DrawLinesInstanced(2, (uint32_t)mesh.Vertices.Size());
+
+    if (mesh.ShowWireframe) {
+      list.BindPipeline(shader.Wireframe);
+      list.SetObjectData({model, normal, id, 1});
+      list.DrawLinesInstanced(2, (uint32_t)mesh.Vertices.Size());
+    }
+    return;
+  }
+
+  // fill and wireframe in a single draw if the shader has a WIREFRAME variant, otherwise a second draw in line mode
+  if (mesh.ShowFill && mesh.ShowWireframe && shader.Overlay != nullptr && shader.Overlay->IsReady()) {
+    list.BindPipeline(shader.OverlayFill);
+    list.BindVertexArray(mesh.VAO.get(), mesh.Vertices.GetID(), mesh.Indices.GetID());
+    list.BindStorageBuffer(1, mesh.Vertices.GetID());
+    list.BindStorageBuffer(2, mesh.Indices.GetID());
+    list.SetObjectData({model, normal, id, 0});
+    list.DrawElements(indexCount);
+    return;
+  }
+
+  list.BindVertexArray(mesh.VAO.get(), mesh.Vertices.GetID(), mesh.Indices.GetID());
+
+  if (mesh.ShowFill) {
+    list.BindPipeline(shader.Fill);
+    list.SetObjectData({model, normal, id, 0});
+    list.DrawElements(indexCount);
+  }
+
+  if (mesh.ShowWireframe) {
+    list.BindPipeline(shader.Wireframe);
+    list.SetObjectData({model, normal, id, 1});
+    list.DrawElements(indexCount);
+  }
+}
+
+void Systems::RenderScene(Application &app, Scene &scene, TimeStep &deltaTime)
+{
   auto camview = scene.m_Registry.view<Component::Camera>();
   if (camview.size() == 0) {
     HAM_ERROR("No camera in scene!");
+    DebugDraw::Clear();  // nothing to draw them with, don't let them pile up
     return;
   }
 
   auto cameraEntity = scene.GetActiveCamera();
-  auto &cameraProjection = cameraEntity.GetComponent<Component::Camera>().Projection;
   auto &cameraTransform = cameraEntity.GetComponent<Component::Transform>();
-  auto cameraView = math::inverse(cameraTransform.ToMatrix());
 
-  auto view = scene.m_Registry.view<Component::Mesh, Component::Transform, Component::ShaderList>();
+  FrameData frame;
+  frame.View = math::inverse(cameraTransform.ToMatrix());
+  frame.Projection = cameraEntity.GetComponent<Component::Camera>().Projection;
+  frame.ObjectColor = math::vec3(1, 1, 1);
+  frame.WireframeColor = math::vec3();
+  frame.Resolution = app.GetWindow().GetSize();
+  frame.Time = app.GetTime();
 
-  int index = 0;
-  for (auto &ent : view) {
-    Entity entity = {ent, &scene};
+  // programs may have been relinked and other passes set GL state since last frame
+  PipelineCache::Invalidate();
 
-    auto &mesh = entity.GetComponent<Component::Mesh>();
-    auto &transform = entity.GetComponent<Component::Transform>();
-    auto &shaderList = entity.GetComponent<Component::ShaderList>();
-    auto &tag = entity.GetComponent<Component::Tag>();
+  Systems::FlushMeshEdits(app, scene);
+  Systems::UpdateOcclusion(app, scene, frame);
+  Systems::UpdateLights(app, scene, frame);
 
-    for (auto &shaderName : shaderList.Names) {
-      auto shader = ShaderLibrary::Get(shaderName);
+  // terrain is opaque, it has to be in the depth buffer before blended meshes are drawn over it
+  Systems::RenderTerrain(app, scene, frame);
 
-      if (shader == nullptr)  // TODO: Use default shader instead
-        continue;
+  if (app.GetRenderMode() == RENDER_MODE_MULTI_DRAW_INDIRECT) {
+    Systems::RenderSceneIndirect(app, scene, frame);
+  }
+  else {
+    static std::vector<entt::entity> entities;
+    static std::vector<entt::entity> transparent;
+    static std::vector<math::mat4> transparentModels;
+    static std::vector<RenderCommandList> lists;
+    static RenderCommandList transparentList;
+    static DepthSorter sorter;
+    auto &culler = app.GetOcclusionCuller();
 
-      mesh.VAO.Bind();
-      shader->Bind();
+    {
+      HAM_PROFILE_SCOPE_NAMED("Record Render Commands");
+      auto view = scene.m_Registry.view<Component::Mesh, Component::Transform, Component::ShaderList>();
+      entities.clear();
+      transparent.clear();
+      for (auto entity : view) {
+        // the workers below only read what is resolved here
+        auto &mesh = view.get<Component::Mesh>(entity);
+        Systems::ResolveShaders(view.get<Component::ShaderList>(entity), GetMeshState(mesh), false);
+        (mesh.AlphaBlending ? transparent : entities).push_back(entity);
+      }
 
-      {
-        shader->SetUniformMat4f("uModel", transform.ToMatrix());
-        shader->SetUniformMat4f("uView", cameraView);
-        shader->SetUniformMat4f("uProjection", cameraProjection);
+      // each batch records into its own list, replayed in batch order so draw order matches the single threaded path
+      uint32_t count = (uint32_t)entities.size();
+      uint32_t batches = JobSystem::GetBatchCount(count, 64);
+      if (lists.size() < batches)
+        lists.resize(batches);
+
+      JobSystem::ParallelFor(count, 64, [&](uint32_t begin, uint32_t end, uint32_t batch) {
+        auto &list = lists[batch];
+        list.Clear();
+        list.SetFrameData(frame);
+
+        for (uint32_t index = begin; index < end; index++) {
+          auto &mesh = scene.m_Registry.get<Component::Mesh>(entities[index]);
+          auto &transform = scene.m_Registry.get<Component::Transform>(entities[index]);
+          auto &shaderList = scene.m_Registry.get<Component::ShaderList>(entities[index]);
+
+          auto model = transform.ToMatrix();
+          if (!culler.IsVisible(mesh.BoundsMin, mesh.BoundsMax, model))
+            continue;
+
+          math::mat4 normal = GetNormalMatrix(model);
+          for (auto &shader : shaderList.Resolved)
+            Systems::RecordMesh(list, mesh, model, normal, shader, (int)entt::to_integral(entities[index]));
+        }
+      });
+
+      for (uint32_t batch = batches; batch < lists.size(); batch++)
+        lists[batch].Clear();
+
+      // blended meshes are recorded after everything opaque, farthest first
+      sorter.Clear();
+      transparentModels.resize(transparent.size());
+      for (uint32_t index = 0; index < transparent.size(); index++) {
+        auto &mesh = scene.m_Registry.get<Component::Mesh>(transparent[index]);
+        auto &model = transparentModels[index];
+        model = scene.m_Registry.get<Component::Transform>(transparent[index]).ToMatrix();
+        if (!culler.IsVisible(mesh.BoundsMin, mesh.BoundsMax, model))
+          continue;
+
+        math::vec3 center = (model * math::vec4((mesh.BoundsMin + mesh.BoundsMax) * 0.5f, 1.0f)).xyz;
+        sorter.Add(center, index);
+      }
 
-        shader->SetUniform3f("uLightPos", lightPos);
-        shader->SetUniform3f("uLightColor", lightColor);
-        shader->SetUniform1f("uTime", app.GetTime());
-        shader->SetUniform2f("uResolution", app.GetWindow().GetSize());
+      transparentList.Clear();
+      transparentList.SetFrameData(frame);
+      for (uint32_t index : sorter.Sort(frame.View)) {
+        auto &mesh = scene.m_Registry.get<Component::Mesh>(transparent[index]);
+        auto &model = transparentModels[index];
+        math::mat4 normal = GetNormalMatrix(model);
+        for (auto &shader : scene.m_Registry.get<Component::ShaderList>(transparent[index]).Resolved)
+          Systems::RecordMesh(transparentList, mesh, model, normal, shader, (int)entt::to_integral(transparent[index]));
+      }
+    }
 
-        shader->SetUniform3f("uObjectColor", math::vec3(1, 1, 1));
-        shader->SetUniform3f("uWireframeColor", math::vec3());
+    {
+      HAM_PROFILE_SCOPE_NAMED("Execute Render Commands");
+      for (auto &list : lists)
+        list.Execute();
+      transparentList.Execute();
+    }
+  }
 
-        shader->SetUniform1i("uID", index);
-      }
+  Systems::RenderParticles(app, scene, frame, deltaTime);
+  DebugDraw::Render(app.GetStreamBuffer(), frame.Projection * frame.View);
 
-      {
-        glEnable(GL_DEPTH_TEST);
+  // the rest of the frame (and the next glClear) expects depth writes, no blending and filled polygons
+  static const PipelineID defaultPipeline = PipelineCache::Get(PipelineState());
+  PipelineCache::Bind(defaultPipeline);
+}
 
-        if (mesh.BackfaceCulling) {
-          glEnable(GL_CULL_FACE);
-          glCullFace(GL_BACK);
-        }
-        else {
-          glDisable(GL_CULL_FACE);
-        }
+// False only if the box is entirely outside one of the clip planes
+static bool IsInFrustum(const math::mat4 &modelViewProjection, const math::vec3 &boundsMin, const math::vec3 &boundsMax)
+{
+  int outside[6] = {};
+  for (int i = 0; i < 8; i++) {
+    math::vec3 corner = {(i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y, (i & 4) ? boundsMax.z : boundsMin.z};
+    math::vec4 clip = modelViewProjection * math::vec4(corner, 1.0f);
+    outside[0] += clip.x < -clip.w;
+    outside[1] += clip.x > clip.w;
+    outside[2] += clip.y < -clip.w;
+    outside[3] += clip.y > clip.w;
+    outside[4] += clip.z < -clip.w;
+    outside[5] += clip.z > clip.w;
+  }
+  for (int plane = 0; plane < 6; plane++) {
+    if (outside[plane] == 8)
+      return false;
+  }
+  return true;
+}
 
-        if (mesh.AlphaBlending) {
-          glEnable(GL_BLEND);
-          glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-          glBlendEquation(GL_FUNC_ADD);
-        }
-        else {
-          glDisable(GL_BLEND);
-        }
+// Terrains pick their quadtree nodes for the active camera and are drawn straight out of their own vertex slots,
+// one glMultiDrawElementsIndirect per terrain and shader. Nodes outside the frustum or behind occluders are skipped.
+void Systems::RenderTerrain(Application &app, Scene &scene, const FrameData &frame)
+{
+  HAM_PROFILE_SCOPE();
 
-        if (mesh.ShowFill || shaderName == "vertex-normal") {
-          shader->SetUniform1i("uIsWireframe", 0);
-          glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-          glDrawElements(GL_TRIANGLES, (GLushort)mesh.Indices.GetData().size(), GL_UNSIGNED_INT, 0);
-        }
+  static std::vector<DrawElementsIndirectCommand> commands;
+  static std::vector<IndirectDrawData> draws;
 
-        if (mesh.ShowWireframe) {
-          shader->SetUniform1i("uIsWireframe", 1);
-          glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-          glDrawElements(GL_TRIANGLES, (GLushort)mesh.Indices.GetData().size(), GL_UNSIGNED_INT, 0);
-        }
-      }
+  auto &culler = app.GetOcclusionCuller();
+  math::vec3 cameraPosition = (math::inverse(frame.View) * math::vec4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+
+  auto view = scene.m_Registry.view<Component::Terrain, Component::Transform, Component::ShaderList>();
+  for (auto &entity : view) {
+    auto &terrain = view.get<Component::Terrain>(entity);
+    if (terrain.Field == nullptr)
+      continue;
+
+    auto &field = *terrain.Field;
+    auto model = view.get<Component::Transform>(entity).ToMatrix();
+    field.Update((math::inverse(model) * math::vec4(cameraPosition, 1.0f)).xyz, terrain.LodDistance);
+
+    IndirectDrawData draw;
+    draw.Model = model;
+    draw.Normal = GetNormalMatrix(model);
+    draw.ID = (int)entt::to_integral(entity);
+    draw.FirstIndex = 0;
+    draw.BaseVertex = 0;
+
+    commands.clear();
+    draws.clear();
+    uint64_t triangles = 0;
+    math::mat4 modelViewProjection = frame.Projection * frame.View * model;
+    for (auto &patch : field.GetPatches()) {
+      if (!IsInFrustum(modelViewProjection, patch.BoundsMin, patch.BoundsMax) || !culler.IsVisible(patch.BoundsMin, patch.BoundsMax, model))
+        continue;
+      commands.push_back(patch.Command);
+      draws.push_back(draw);
+      triangles += patch.Command.Count / 3;
     }
 
-    index++;
-  }
+    if (commands.empty())
+      continue;
+
+    auto &stream = app.GetStreamBuffer();
+    size_t commandOffset = 0, drawOffset = 0;
+    if (stream.Write(commands, commandOffset) && stream.Write(draws, drawOffset)) {
+      stream.BindRange(GL_SHADER_STORAGE_BUFFER, 0, drawOffset, draws.size() * sizeof(IndirectDrawData));
+      stream.Bind(GL_DRAW_INDIRECT_BUFFER);
+    }
+    else {
+      commandOffset = 0;
+      app.GetIndirectDrawDataBuffer().SetData(draws);
+      app.GetIndirectDrawDataBuffer().BindBase(0);
+      app.GetIndirectCommandBuffer().SetData(commands);
+      app.GetIndirectCommandBuffer().Bind();
+    }
+
+    auto vertexArray = VertexArray::Get(Component::VertexData::GetLayout());
+    vertexArray->Bind();
+    vertexArray->SetBuffers(field.GetVertexBufferID(), field.GetIndexBufferID());
 
-  // rotate light about z axis
-  lightPos = (math::rotateAxisAngle(math::vec3(0.0f, 0.0f, 1.0f), math::radians(90.0f) * deltaTime) * math::vec4(lightPos, 1.0f)).xyz;
+    auto &shaderList = view.get<Component::ShaderList>(entity);
+    Systems::ResolveShaders(shaderList, RENDER_STATE_DEPTH_TEST | RENDER_STATE_CULL_BACK, true);
+    for (auto &resolved : shaderList.Resolved) {
+      auto &shader = resolved.Indirect;
+      if (shader == nullptr || !shader->IsReady())
+        continue;
+
+      PipelineCache::Bind(resolved.IndirectFill);
+      RenderCommandList::ApplyFrameData(*shader, frame);
+      shader->SetUniform1i("uDrawOffset", 0);
+      shader->SetUniform1i("uIsWireframe", 0);
+
+      glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void *)commandOffset, (GLsizei)commands.size(), 0);
+      RenderStats::Add(RenderCounter::DRAW_CALLS);
+      RenderStats::Add(RenderCounter::TRIANGLES, triangles);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
 }
 
-void Systems::RenderObjectPickerFrame(Application &app, Scene &scene, TimeStep &deltaTime)
+// Emitters spawn and retire on the render thread, then every live particle is simulated across the JobSystem
+// straight into the stream ring. All emitters are drawn by one glMultiDrawArraysIndirect of camera facing quads:
+// one command per emitter, BaseInstance is where its particles start and gl_DrawID picks its colors and sizes.
+void Systems::RenderParticles(Application &app, Scene &scene, const FrameData &frame, TimeStep &deltaTime)
 {
-  auto camview = scene.m_Registry.view<Component::Camera>();
-  if (camview.size() == 0) {
-    HAM_ERROR("No camera in scene!");
+  HAM_PROFILE_SCOPE();
+
+  struct EmitterRange {
+    ParticlePool *Pool;
+    uint32_t First;  // into the frame's instances
+    math::vec3 Gravity;
+    float Lifetime;
+  };
+
+  static std::vector<EmitterRange> ranges;
+  static std::vector<ParticleEmitterData> emitterData;
+  static std::vector<DrawArraysIndirectCommand> commands;
+  static std::vector<uint8_t> staging;
+  ranges.clear();
+  emitterData.clear();
+  commands.clear();
+
+  float dt = deltaTime.GetSeconds();
+  uint32_t total = 0;
+
+  auto view = scene.m_Registry.view<Component::ParticleEmitter, Component::Transform>();
+  for (auto &entity : view) {
+    auto &emitter = view.get<Component::ParticleEmitter>(entity);
+    auto &pool = *emitter.Pool;
+    pool.Reserve(emitter.GetCapacity());
+    pool.Retire(dt, emitter.Lifetime);
+
+    if (emitter.Emitting) {
+      auto model = view.get<Component::Transform>(entity).ToMatrix();
+      math::vec3 origin = (model * math::vec4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+      math::vec3 direction = (model * math::vec4(math::up(), 0.0f)).xyz;
+      direction = math::normalize(direction);
+      pool.Emit(dt, emitter.Rate, origin, direction, emitter.Speed, emitter.Spread);
+    }
+
+    uint32_t count = pool.GetCount();
+    if (count == 0)
+      continue;
+
+    ranges.push_back({&pool, total, emitter.Gravity, emitter.Lifetime});
+    emitterData.push_back({emitter.StartColor, emitter.EndColor, math::vec4(emitter.StartSize, emitter.EndSize, 0.0f, 0.0f)});
+    commands.push_back({4, count, 0, total});
+    total += count;
+  }
+
+  if (total == 0)
     return;
+
+  // instances, emitter data and draw commands share one allocation, the storage ranges are aligned for binding
+  constexpr size_t StorageAlignment = 256;
+  size_t instanceSize = total * sizeof(ParticleInstance);
+  size_t emitterOffset = (instanceSize + StorageAlignment - 1) / StorageAlignment * StorageAlignment;
+  size_t emitterSize = emitterData.size() * sizeof(ParticleEmitterData);
+  size_t commandOffset = emitterOffset + emitterSize;
+  size_t size = commandOffset + commands.size() * sizeof(DrawArraysIndirectCommand);
+
+  auto &stream = app.GetStreamBuffer();
+  size_t base = 0;
+  uint8_t *memory = (uint8_t *)stream.Allocate(size, base);
+  bool streamed = memory != nullptr;
+  if (!streamed) {
+    staging.resize(size);
+    memory = staging.data();
+    base = 0;
   }
 
-  auto cameraEntity = scene.GetActiveCamera();
-  auto &cameraProjection = cameraEntity.GetComponent<Component::Camera>().Projection;
-  auto &cameraTransform = cameraEntity.GetComponent<Component::Transform>();
-  auto cameraView = math::inverse(cameraTransform.ToMatrix());
+  memcpy(memory + emitterOffset, emitterData.data(), emitterSize);
+  memcpy(memory + commandOffset, commands.data(), commands.size() * sizeof(DrawArraysIndirectCommand));
+
+  {
+    HAM_PROFILE_SCOPE_NAMED("Simulate Particles");
+    auto *instances = (ParticleInstance *)memory;
+    JobSystem::ParallelFor(total, 4096, [&](uint32_t begin, uint32_t end, uint32_t batch) {
+      // a batch can cover the end of one emitter and the start of the next
+      auto range = std::upper_bound(ranges.begin(), ranges.end(), begin, [](uint32_t particle, const EmitterRange &range) { return particle < range.First; }) - 1;
+      for (; begin < end; ++range) {
+        uint32_t last = std::min(end, range->First + range->Pool->GetCount());
+        range->Pool->Simulate(begin - range->First, last - range->First, dt, range->Gravity, range->Lifetime, instances + begin);
+        begin = last;
+      }
+    });
+  }
 
+  uint32_t buffer;
+  if (streamed) {
+    buffer = stream.GetID();
+    RenderStats::Add(RenderCounter::BUFFER_UPLOADS);
+    RenderStats::Add(RenderCounter::UPLOAD_BYTES, size);
+  }
+  else {
+    app.GetParticleBuffer().SetData(staging);
+    buffer = app.GetParticleBuffer().GetID();
+  }
+
+  auto shader = ShaderLibrary::Get("particles");
+  if (shader == nullptr || !shader->IsReady())
+    return;
+
+  // additive, depth tested against the scene without writing depth or entity ids
+  PipelineState state;
+  state.Program = shader.get();
+  state.DepthWrite = false;
+  state.WriteEntityID = false;
+  state.Blend = BlendMode::ADDITIVE;
+  PipelineCache::Bind(PipelineCache::Get(state));
+
+  RenderCommandList::ApplyFrameData(*shader, frame);
+  VertexArray::Get(VertexLayout())->Bind();  // the quads come from gl_VertexID, core profile still needs a VAO
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 6, buffer, base, instanceSize);
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 7, buffer, base + emitterOffset, emitterSize);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+
+  glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, (void *)(base + commandOffset), (GLsizei)commands.size(), 0);
+  RenderStats::Add(RenderCounter::DRAW_CALLS);
+  RenderStats::Add(RenderCounter::TRIANGLES, (uint64_t)total * 2);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Vertex edits made during the frame (scripts, the editor) are uploaded once here, before anything reads the buffers.
+void Systems::FlushMeshEdits(Application &app, Scene &scene)
+{
+  HAM_PROFILE_SCOPE();
+
+  auto &geometry = app.GetGeometryBuffer();
   auto view = scene.m_Registry.view<Component::Mesh>();
+  for (auto &entity : view)
+    view.get<Component::Mesh>(entity).FlushVertices(geometry);
+}
 
-  int index = 0;
-  for (auto &ent : view) {
-    Entity entity = {ent, &scene};
+// Occluders are rasterized into the CPU depth buffer before anything is recorded, so both render paths can
+// drop meshes whose bounds end up fully hidden.
+void Systems::UpdateOcclusion(Application &app, Scene &scene, const FrameData &frame)
+{
+  HAM_PROFILE_SCOPE();
 
-    auto &mesh = entity.GetComponent<Component::Mesh>();
-    auto &transform = entity.GetComponent<Component::Transform>();
-    auto &shaderList = entity.GetComponent<Component::ShaderList>();
-    auto &tag = entity.GetComponent<Component::Tag>();
-    auto shader = ShaderLibrary::Get("object-picker");
+  auto &culler = app.GetOcclusionCuller();
+  culler.BeginFrame(frame.Projection * frame.View);
+  if (!culler.IsEnabled())
+    return;
 
-    mesh.VAO.Bind();
-    shader->Bind();
+  auto view = scene.m_Registry.view<Component::Occluder, Component::Transform>();
+  for (auto &entity : view) {
+    auto &occluder = view.get<Component::Occluder>(entity);
+    auto &transform = view.get<Component::Transform>(entity);
+    culler.AddOccluder(occluder.Vertices, occluder.Indices, transform.ToMatrix());
+  }
 
-    {
-      shader->SetUniformMat4f("uModel", transform.ToMatrix());
-      shader->SetUniformMat4f("uView", cameraView);
-      shader->SetUniformMat4f("uProjection", cameraProjection);
+  culler.Rasterize();
+}
 
-      shader->SetUniform1f("uTime", app.GetTime());
-      shader->SetUniform2f("uResolution", app.GetWindow().GetSize());
+// Point lights are binned into the camera's froxel grid and the result is bound as SSBOs 3-5 for include/lights.glsl.
+void Systems::UpdateLights(Application &app, Scene &scene, FrameData &frame)
+{
+  HAM_PROFILE_SCOPE();
 
-      shader->SetUniform3f("uObjectColor", math::vec3(1, 1, 1));
-      shader->SetUniform3f("uWireframeColor", math::vec3());
-      shader->SetUniform1i("uID", index);
-      shader->SetUniform1i("uTotalObjects", (int)view.size());
-    }
+  auto &camera = scene.GetActiveCamera().GetComponent<Component::Camera>();
+  auto &clusters = app.GetLightClusters();
+  clusters.BeginFrame(frame.View, frame.Projection, camera.Near, camera.Far);
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDrawElements(GL_TRIANGLES, (GLushort)mesh.Indices.GetData().size(), GL_UNSIGNED_INT, 0);
+  auto view = scene.m_Registry.view<Component::Light, Component::Transform>();
+  for (auto &entity : view) {
+    auto &light = view.get<Component::Light>(entity);
+    math::vec3 position = (view.get<Component::Transform>(entity).ToMatrix() * math::vec4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+    clusters.AddLight(position, light.Color, light.Intensity, light.Radius);
+  }
 
-    index++;
+  clusters.Build();
+
+  // empty lists are not uploaded, no cluster references them
+  if (!clusters.GetLights().empty()) {
+    app.GetLightBuffer().SetData(clusters.GetLights());
+    app.GetLightIndexBuffer().SetData(clusters.GetLightIndices());
   }
+  app.GetLightClusterBuffer().SetData(clusters.GetClusters());
+
+  app.GetLightBuffer().BindBase(3);
+  app.GetLightClusterBuffer().BindBase(4);
+  app.GetLightIndexBuffer().BindBase(5);
+
+  // scenes without lights keep the unlit look
+  frame.AmbientLight = view.begin() == view.end() ? math::vec3(1.0f, 1.0f, 1.0f) : math::vec3(0.2f, 0.2f, 0.2f);
+  frame.ClusterDepthRange = {clusters.GetNear(), clusters.GetFar()};
 }
 
-void Systems::HandleObjectPicker(Application &app, Scene &scene, FrameBuffer &frameBuffer, TimeStep &deltaTime, std::atomic_bool &clicked)
+// Meshes are drawn from the shared geometry buffer. Opaque draws are bucketed by the state they need (shader,
+// wireframe, culling, blending) and each bucket is submitted with one glMultiDrawElementsIndirect. Blended meshes are
+// drawn after them, sorted back to front, where only neighbours with the same shader and state share a draw call.
+// Shaders without an INDIRECT variant are recorded the old way, in the same place of that order.
+// The vertex shader finds its per-draw data at uDrawOffset + gl_DrawID since gl_DrawID restarts at 0 for every call.
+void Systems::RenderSceneIndirect(Application &app, Scene &scene, const FrameData &frame)
 {
-  frameBuffer.Bind();
-  frameBuffer.Clear(AttachmentType::COLOR | AttachmentType::DEPTH | AttachmentType::STENCIL);
-  Systems::RenderObjectPickerFrame(app, scene, deltaTime);
-  frameBuffer.Unbind();
+  HAM_PROFILE_SCOPE();
+
+  struct IndirectBatch {
+    std::vector<DrawElementsIndirectCommand> Commands;
+    std::vector<IndirectDrawData> Draws;
+    PipelineID Pipeline;
+  };
+
+  // a blended draw that has no indirect variant goes into a fallback run, so it still lands at its sorted position
+  struct SortedRun {
+    IndirectBatch Batch;
+    RenderCommandList Fallback;
+    bool IsFallback;
+  };
+
+  struct TransparentMesh {
+    entt::entity Entity;
+    math::mat4 Model;
+    DrawElementsIndirectCommand Command;
+  };
+
+  // opaque batches are indexed by pipeline ID (which includes the program), used lists the ones with draws
+  static std::vector<IndirectBatch> batches;
+  static std::vector<PipelineID> used;
+  static std::vector<SortedRun> runs;  // sorted blended draws, the first runCount are used this frame
+  static std::vector<TransparentMesh> transparent;
+  static DepthSorter sorter;
+  static std::vector<DrawElementsIndirectCommand> commands;
+  static std::vector<IndirectDrawData> draws;
+  static RenderCommandList fallback;
+
+  for (PipelineID pipeline : used) {
+    batches[pipeline].Commands.clear();
+    batches[pipeline].Draws.clear();
+  }
+  used.clear();
+  uint32_t runCount = 0;
+  transparent.clear();
+  sorter.Clear();
+
+  fallback.Clear();
+  fallback.SetFrameData(frame);
+
+  auto &geometry = app.GetGeometryBuffer();
+
+  auto getBatch = [&](PipelineID pipeline, bool sorted) -> IndirectBatch & {
+    if (!sorted) {
+      if (batches.size() <= pipeline)
+        batches.resize(PipelineCache::GetCount());
+      auto &batch = batches[pipeline];
+      if (batch.Commands.empty()) {
+        batch.Pipeline = pipeline;
+        used.push_back(pipeline);
+      }
+      return batch;
+    }
 
-  auto display = app.GetWindow().GetFramebufferSize();
+    // sorted draws can only join the run right before them
+    if (runCount == 0 || runs[runCount - 1].IsFallback || runs[runCount - 1].Batch.Pipeline != pipeline) {
+      if (runs.size() == runCount)
+        runs.emplace_back();
+      auto &run = runs[runCount++];
+      run.Batch.Commands.clear();
+      run.Batch.Draws.clear();
+      run.Batch.Pipeline = pipeline;
+      run.IsFallback = false;
+    }
+    return runs[runCount - 1].Batch;
+  };
+
+  auto getFallback = [&](bool sorted) -> RenderCommandList & {
+    if (!sorted)
+      return fallback;
+
+    if (runCount == 0 || !runs[runCount - 1].IsFallback) {
+      if (runs.size() == runCount)
+        runs.emplace_back();
+      auto &run = runs[runCount++];
+      run.Batch.Commands.clear();
+      run.Batch.Draws.clear();
+      run.Fallback.Clear();
+      run.Fallback.SetFrameData(frame);
+      run.IsFallback = true;
+    }
+    return runs[runCount - 1].Fallback;
+  };
 
-  std::vector<unsigned char> value = frameBuffer.ReadPixels((int)Input::GetMousePosition().x, display.y - (int)Input::GetMousePosition().y, 1, 1);
-  uint32_t r = value[0];
-  uint32_t g = value[1];
-  uint32_t b = value[2];
-  uint32_t a = value[3];
+  // per mesh and shader this only appends a command and a draw, the variants and pipelines were resolved before
+  auto addMesh = [&](entt::entity ent, Component::Mesh &mesh, const math::mat4 &model, const DrawElementsIndirectCommand &command, bool sorted) {
+    int id = (int)entt::to_integral(ent);
 
-  uint32_t id = r + (g << 8) + (b << 16) + (a << 24);  // must be uint, dont change to int
+    IndirectDrawData draw;
+    draw.Model = model;
+    draw.Normal = GetNormalMatrix(model);
+    draw.ID = id;
 
-  auto view = scene.m_Registry.view<Component::Mesh>();
-  if (id > view.size()) {
-    scene.ClearHoveredEntity();
+    draw.FirstIndex = (int32_t)command.FirstIndex;
+    draw.BaseVertex = command.BaseVertex;
+
+    for (auto &shader : scene.m_Registry.get<Component::ShaderList>(ent).Resolved) {
+      if (shader.Indirect == nullptr || !shader.Indirect->IsReady()) {  // no indirect variant of this shader (yet), draw it the old way
+        Systems::RecordMesh(getFallback(sorted), mesh, model, draw.Normal, shader, id);
+        continue;
+      }
+
+      if (mesh.ShowFill && mesh.ShowWireframe && shader.IndirectOverlay != nullptr && shader.IndirectOverlay->IsReady()) {
+        auto &batch = getBatch(shader.IndirectOverlayFill, sorted);
+        batch.Commands.push_back(command);
+        batch.Draws.push_back(draw);
+        continue;
+      }
+
+      for (bool wireframe : {false, true}) {
+        if (wireframe ? !mesh.ShowWireframe : !mesh.ShowFill)
+          continue;
+
+        auto &batch = getBatch(wireframe ? shader.IndirectWireframe : shader.IndirectFill, sorted);
+        batch.Commands.push_back(command);
+        batch.Draws.push_back(draw);
+      }
+    }
+  };
+
+  auto view = scene.m_Registry.view<Component::Mesh, Component::Transform, Component::ShaderList>();
+  for (auto &ent : view) {
+    auto &mesh = view.get<Component::Mesh>(ent);
+    auto &transform = view.get<Component::Transform>(ent);
+    Systems::ResolveShaders(view.get<Component::ShaderList>(ent), GetMeshState(mesh), true);
+
+    if (mesh.GeometryDirty || !geometry.IsValid(mesh.GeometryHandle)) {
+      auto &vertices = mesh.Vertices.GetData();
+      auto &indices = mesh.Indices.GetData();
+      geometry.Free(mesh.GeometryHandle);
+      mesh.GeometryHandle = geometry.Allocate(vertices.data(), (uint32_t)vertices.size(), indices.data(), (uint32_t)indices.size());
+      mesh.GeometryDirty = false;
+    }
+
+    // hidden meshes count as used too, or walls would get their geometry evicted and uploaded again
+    auto command = geometry.Use(mesh.GeometryHandle);
+
+    auto model = transform.ToMatrix();
+    if (!app.GetOcclusionCuller().IsVisible(mesh.BoundsMin, mesh.BoundsMax, model))
+      continue;
+
+    if (mesh.AlphaBlending) {
+      math::vec3 center = (model * math::vec4((mesh.BoundsMin + mesh.BoundsMax) * 0.5f, 1.0f)).xyz;
+      sorter.Add(center, (uint32_t)transparent.size());
+      transparent.push_back({ent, model, command});
+      continue;
+    }
+
+    addMesh(ent, mesh, model, command, false);
   }
-  else {
-    scene.SetHoveredEntity({view[id], &scene});
+
+  for (uint32_t index : sorter.Sort(frame.View)) {
+    auto &mesh = transparent[index];
+    addMesh(mesh.Entity, scene.m_Registry.get<Component::Mesh>(mesh.Entity), mesh.Model, mesh.Command, true);
   }
 
-  if (clicked) {
-    clicked = false;
-    if (id > view.size()) {
-      scene.ClearSelectedEntity();
+  // batches using the same program are submitted back to back
+  std::sort(used.begin(), used.end(), [](PipelineID a, PipelineID b) {
+    uint32_t programA = PipelineCache::GetState(a).ProgramHandle, programB = PipelineCache::GetState(b).ProgramHandle;
+    return programA != programB ? programA < programB : a < b;
+  });
+
+  commands.clear();
+  draws.clear();
+  for (PipelineID pipeline : used) {
+    commands.insert(commands.end(), batches[pipeline].Commands.begin(), batches[pipeline].Commands.end());
+    draws.insert(draws.end(), batches[pipeline].Draws.begin(), batches[pipeline].Draws.end());
+  }
+  for (uint32_t run = 0; run < runCount; run++) {
+    commands.insert(commands.end(), runs[run].Batch.Commands.begin(), runs[run].Batch.Commands.end());
+    draws.insert(draws.end(), runs[run].Batch.Draws.begin(), runs[run].Batch.Draws.end());
+  }
+
+  auto &stream = app.GetStreamBuffer();
+  auto &commandBuffer = app.GetIndirectCommandBuffer();
+  auto &drawBuffer = app.GetIndirectDrawDataBuffer();
+
+  // write straight into the persistently mapped ring, the regular buffers are only used on a frame it overflows
+  size_t commandOffset = 0, drawOffset = 0;
+  bool streamed = false;
+  if (!commands.empty()) {
+    streamed = stream.Write(commands, commandOffset) && stream.Write(draws, drawOffset);
+    if (!streamed) {
+      commandOffset = 0;
+      drawBuffer.SetData(draws);
+      commandBuffer.SetData(commands);
+    }
+  }
+
+  // fallback lists bind their own vertex arrays and storage buffers, the indirect ones are bound again after them
+  bool bound = false;
+  auto bind = [&]() {
+    if (streamed) {
+      stream.BindRange(GL_SHADER_STORAGE_BUFFER, 0, drawOffset, draws.size() * sizeof(IndirectDrawData));
+      stream.Bind(GL_DRAW_INDIRECT_BUFFER);
     }
     else {
-      scene.SetSelectedEntity({view[id], &scene});
+      drawBuffer.BindBase(0);
+      commandBuffer.Bind();
+    }
+
+    geometry.Bind();
+
+    // WIREFRAME variants read their triangles from the shared buffers
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, geometry.GetVertexBufferID());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, geometry.GetIndexBufferID());
+    RenderStats::Add(RenderCounter::STATE_CHANGES, 2);
+    bound = true;
+  };
+
+  auto unbind = [&]() {
+    if (!bound)
+      return;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    geometry.Unbind();
+    bound = false;
+  };
+
+  uint32_t offset = 0;
+  auto submit = [&](const IndirectBatch &batch) {
+    if (batch.Commands.empty())
+      return;
+    if (!bound)
+      bind();
+
+    auto &state = PipelineCache::GetState(batch.Pipeline);
+    PipelineCache::Bind(batch.Pipeline);
+    RenderCommandList::ApplyFrameData(*state.Program, frame);
+    state.Program->SetUniform1i("uDrawOffset", (int)offset);
+    state.Program->SetUniform1i("uIsWireframe", state.Polygon == PolygonMode::LINE ? 1 : 0);
+
+    uint64_t triangles = 0;
+    for (auto &command : batch.Commands)
+      triangles += command.Count / 3;
+    RenderStats::Add(RenderCounter::DRAW_CALLS);
+    RenderStats::Add(RenderCounter::TRIANGLES, triangles);
+
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void *)(commandOffset + offset * sizeof(DrawElementsIndirectCommand)), (GLsizei)batch.Commands.size(), 0);
+    offset += (uint32_t)batch.Commands.size();
+  };
+
+  auto execute = [&](const RenderCommandList &list) {
+    if (list.GetDrawCount() == 0)
+      return;
+    unbind();
+    list.Execute();
+  };
+
+  // everything opaque goes before the first blended draw, which would otherwise hide it through the depth buffer
+  for (PipelineID pipeline : used)
+    submit(batches[pipeline]);
+  execute(fallback);
+
+  for (uint32_t run = 0; run < runCount; run++) {
+    if (runs[run].IsFallback)
+      execute(runs[run].Fallback);
+    else
+      submit(runs[run].Batch);
+  }
+
+  unbind();
+  geometry.EndFrame();
+}
+
+void Systems::HandleObjectPicker(Application &app, Scene &scene, FrameBuffer &frameBuffer, PixelReadback &readback, TimeStep &deltaTime, std::atomic_bool &clicked)
+{
+  static math::ivec2 lastPickPosition = {-1, -1};
+
+  // the scene may be rendered below window resolution, see DynamicResolution
+  auto display = app.GetWindow().GetFramebufferSize();
+  auto mouse = Input::GetMousePosition();
+  int width = (int)frameBuffer.GetWidth(), height = (int)frameBuffer.GetHeight();
+  float scaleX = display.x > 0 ? (float)width / display.x : 1.0f;
+  float scaleY = display.y > 0 ? (float)height / display.y : 1.0f;
+  math::ivec2 pickPosition = {(int)(mouse.x * scaleX), height - 1 - (int)(mouse.y * scaleY)};
+
+  bool inside = pickPosition.x >= 0 && pickPosition.y >= 0 && pickPosition.x < width && pickPosition.y < height;
+  bool moved = pickPosition.x != lastPickPosition.x || pickPosition.y != lastPickPosition.y;
+
+  // the main pass already wrote entity ids to attachment 1, only read it back when something could have changed
+  if (inside && (moved || clicked)) {
+    bool click = clicked;
+
+    // if every slot is still in flight, try again next frame (the click stays queued)
+    if (readback.Request(frameBuffer, 1, pickPosition.x, pickPosition.y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, click ? 1 : 0)) {
+      lastPickPosition = pickPosition;
+      if (click)
+        clicked = false;
+    }
+  }
+  else if (!inside && clicked) {
+    clicked = false;
+    scene.ClearSelectedEntity();
+  }
+
+  std::vector<unsigned char> value;
+  uint64_t wasClick = 0;
+  while (readback.Poll(value, wasClick)) {
+    uint32_t raw;
+    memcpy(&raw, value.data(), sizeof(raw));
+    entt::entity id = (entt::entity)raw;  // cleared to entt::null where nothing was drawn
+
+    bool hit = scene.m_Registry.valid(id) && scene.m_Registry.try_get<Component::Mesh>(id) != nullptr;
+    if (hit)
+      scene.SetHoveredEntity({id, &scene});
+    else
+      scene.ClearHoveredEntity();
+
+    if (wasClick) {
+      if (hit)
+        scene.SetSelectedEntity({id, &scene});
+      else
+        scene.ClearSelectedEntity();
     }
   }
 }
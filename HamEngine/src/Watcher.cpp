@@ -6,6 +6,8 @@
 namespace Ham {
 
 FileListener* FileWatcher::s_FileListener = nullptr;
+std::mutex FileWatcher::s_Mutex;
+uint32_t FileWatcher::s_NextID = 1;
 
 // FileWatcher::FileWatcher() {}
 
@@ -15,18 +17,34 @@ void FileListener::handleFileAction(FW::WatchID watchid, const FW::String& dir,
   auto filePath = dir + (char)std::filesystem::path::preferred_separator + filename;
   HAM_CORE_TRACE("File {0} changed", filePath);
   if (m_WatcherList.find(filePath) != m_WatcherList.end()) {
-    m_WatcherList[filePath].OnFileChanged();
+    m_ChangedFiles.push_back(filePath);
   }
 }
 
 void FileWatcher::Update()
 {
-  for (auto& [filePath, data] : s_FileListener->m_WatcherList) {
-    data.fileWatcher->update();
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    for (auto& [filePath, data] : s_FileListener->m_WatcherList) {
+      data.fileWatcher->update();
+    }
+
+    for (auto& filePath : s_FileListener->m_ChangedFiles) {
+      auto it = s_FileListener->m_WatcherList.find(filePath);
+      if (it == s_FileListener->m_WatcherList.end())
+        continue;
+      for (auto& [id, callback] : it->second.OnFileChanged)
+        callbacks.push_back(callback);
+    }
+    s_FileListener->m_ChangedFiles.clear();
   }
+
+  for (auto& callback : callbacks)
+    callback();
 }
 
-void FileWatcher::Watch(std::string filePath, std::function<void()> OnFileChanged)
+uint32_t FileWatcher::Watch(std::string filePath, std::function<void()> OnFileChanged)
 {
   std::filesystem::path path(filePath);
   path.make_preferred();
@@ -36,12 +54,16 @@ void FileWatcher::Watch(std::string filePath, std::function<void()> OnFileChange
 
   if (std::filesystem::is_directory(path)) {
     HAM_CORE_ERROR("Cannot watch directory {0}. Must specify a file", filePath);
-    return;
+    return 0;
   }
 
-  if (s_FileListener->m_WatcherList.find(filePath) != s_FileListener->m_WatcherList.end()) {
-    HAM_CORE_WARN("File {0} is already being watched", filePath);
-    return;
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  uint32_t id = s_NextID++;
+
+  auto existing = s_FileListener->m_WatcherList.find(filePath);
+  if (existing != s_FileListener->m_WatcherList.end()) {
+    existing->second.OnFileChanged[id] = std::move(OnFileChanged);
+    return id;
   }
 
   auto dirPath = path.parent_path().string();
@@ -61,25 +83,32 @@ void FileWatcher::Watch(std::string filePath, std::function<void()> OnFileChange
     }
     catch (std::exception& e) {
       HAM_CORE_ERROR("Error watching directory: {0}", e.what());
-      return;
+      return 0;
     }
   }
 
-  s_FileListener->m_WatcherList[filePath] = FileListenerData{std::move(OnFileChanged), watcher};
+  auto& data = s_FileListener->m_WatcherList[filePath];
+  data.OnFileChanged[id] = std::move(OnFileChanged);
+  data.fileWatcher = watcher;
+  return id;
 }
 
-void FileWatcher::Unwatch(std::string filePath)
+void FileWatcher::Unwatch(std::string filePath, uint32_t id)
 {
   std::filesystem::path path(filePath);
   path.make_preferred();
   filePath = path.string();
 
   HAM_CORE_TRACE("Unwatching file {0}", filePath);
-  if (s_FileListener->m_WatcherList.find(filePath) == s_FileListener->m_WatcherList.end()) {
+  std::lock_guard<std::mutex> lock(s_Mutex);
+  auto it = s_FileListener->m_WatcherList.find(filePath);
+  if (it == s_FileListener->m_WatcherList.end() || it->second.OnFileChanged.erase(id) == 0) {
     HAM_CORE_WARN("File {0} is not being watched", filePath);
     return;
   }
-  s_FileListener->m_WatcherList.erase(filePath);
+
+  if (it->second.OnFileChanged.empty())
+    s_FileListener->m_WatcherList.erase(it);
 }
 
 }  // namespace Ham
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "Ham/Events/Event.h"
 #include "imgui.h"
 
+#include <cstdlib>
+
 #ifdef _MSC_VER
 #define SSCANF sscanf_s
 #else
@@ -28,6 +30,8 @@ static void opengl_error_callback(GLenum source, GLenum type, GLuint id, GLenum
 Window::Window() {}
 Window::~Window()
 {
+  if (m_LoaderContext != nullptr)
+    glfwDestroyWindow(m_LoaderContext);
   glfwDestroyWindow(m_Window);
   glfwTerminate();
 }
@@ -37,6 +41,9 @@ void Window::Init(Application *app)
   m_Application = app;
   glfwSetErrorCallback(glfw_error_callback);
 
+  if (IsHeadless())
+    InitHeadlessPlatform();
+
   HAM_CORE_ASSERT(glfwInit(), "Could not initialize GLFW!");
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -47,11 +54,22 @@ void Window::Init(Application *app)
   // glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
 
   // Create window with graphics context
-  m_Window = glfwCreateWindow(GetSpecification().Width, GetSpecification().Height, GetSpecification().Name.c_str(), nullptr, nullptr);
+  if (IsHeadless())
+    m_Window = CreateHeadlessWindow();
+  else
+    m_Window = glfwCreateWindow(GetSpecification().Width, GetSpecification().Height, GetSpecification().Name.c_str(), nullptr, nullptr);
   HAM_CORE_ASSERT(m_Window != nullptr, "Could not create GLFW window!");
   glfwMakeContextCurrent(m_Window);
   gladLoadGL(glfwGetProcAddress);  // Initialize OpenGL loader
 
+  // hidden context sharing objects with the window, lets ShaderCompiler compile off the render thread
+  if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_LoaderContext = glfwCreateWindow(1, 1, "Loader", nullptr, m_Window);
+    glfwWindowHint(GLFW_VISIBLE, IsHeadless() ? GLFW_FALSE : GLFW_TRUE);
+    glfwMakeContextCurrent(m_Window);
+  }
+
   // glEnable(GL_DEBUG_OUTPUT);                              // Debug
   glDebugMessageCallback(opengl_error_callback, nullptr);
 
@@ -282,6 +300,40 @@ void Window::Update()
 {
 }
 
+void Window::InitHeadlessPlatform()
+{
+  // llvmpipe only advertises GL 4.5, the overrides unlock the 4.6 features it already implements.
+  // Values set by the user win.
+#ifndef _WIN32
+  setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+  setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+#endif
+
+#ifdef GLFW_PLATFORM_NULL
+  // the null platform needs no display server, its contexts come from EGL (surfaceless) or OSMesa
+  if (glfwPlatformSupported(GLFW_PLATFORM_NULL))
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  else
+    HAM_CORE_WARN("GLFW was built without the null platform, headless mode falls back to a hidden window");
+#endif
+}
+
+GLFWwindow *Window::CreateHeadlessWindow()
+{
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_FOCUS_ON_SHOW, GLFW_FALSE);
+
+  // the window's own surface is never presented, the scene is rendered into Application's framebuffer
+  for (int api : {GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API, GLFW_NATIVE_CONTEXT_API}) {
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+    GLFWwindow *window = glfwCreateWindow(GetSpecification().Width, GetSpecification().Height, GetSpecification().Name.c_str(), nullptr, nullptr);
+    if (window != nullptr)
+      return window;
+  }
+
+  return nullptr;
+}
+
 void Window::SetTitle(const std::string &title)
 {
   glfwSetWindowTitle(m_Window, title.c_str());
@@ -348,6 +400,7 @@ float Window::GetAspectRatio() const
   return (float)width / (float)height;
 }
 bool Window::IsVSync() const { return m_Application->GetSpecification().VSync; }
+bool Window::IsHeadless() const { return m_Application->GetSpecification().Headless; }
 const std::string &Window::GetTitle() const { return m_Application->GetSpecification().Name; }
 const ApplicationSpecification &Window::GetSpecification() const { return m_Application->GetSpecification(); }
 
@@ -355,6 +408,9 @@ void Window::ApplySavedSettings()
 {
   auto &settings = m_Application->m_Specification;
 
+  if (IsHeadless())  // no monitors to place the window on, keep the requested size
+    return;
+
   int monitorCount;
   glfwGetMonitors(&monitorCount);
   auto monitor = glfwGetCurrentMonitor(GetWindowHandle());
@@ -183,9 +183,6 @@ void HamLayer::OnAttach()
     // mesh.Indicies.Bind();
     // mesh.Verticies.Bind();
 
-    mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Position));
-    mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Normal));
-
     mesh.ShowWireframe = true;
 
     auto &scriptList = entity.AddComponent<Component::NativeScriptList>();
@@ -212,9 +209,6 @@ void HamLayer::OnAttach()
     // mesh.Indicies.Bind();
     // mesh.Verticies.Bind();
 
-    mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Position));
-    mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Normal));
-
     // mesh.VAO.Unbind();
     // mesh.Verticies.Unbind();
     // mesh.Indicies.Unbind();
@@ -245,9 +239,6 @@ void HamLayer::OnAttach()
   //         // mesh.Indicies.Bind();
   //         // mesh.Verticies.Bind();
 
-  //         mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Position));
-  //         mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Normal));
-
   //         // mesh.VAO.Unbind();
   //         // mesh.Verticies.Unbind();
   //         // mesh.Indicies.Unbind();
@@ -272,9 +263,6 @@ void HamLayer::OnAttach()
     // mesh.Indicies.Bind();
     // mesh.Verticies.Bind();
 
-    mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Position));
-    mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Normal));
-
     // mesh.VAO.Unbind();
     // mesh.Verticies.Unbind();
     // mesh.Indicies.Unbind();
@@ -285,6 +273,42 @@ void HamLayer::OnAttach()
     entity.SetParent(cubesParent);
   }
 
+  {
+    auto entity = m_Scene.CreateEntity("Key Light");
+    entity.GetComponent<Component::Transform>().Position = math::vec3(3.0f, -2.0f, 4.0f);
+    entity.AddComponent<Component::Light>(math::vec3(1.0f, 0.95f, 0.9f), 1.0f, 15.0f);
+  }
+
+  {
+    auto entity = m_Scene.CreateEntity("Red Light");
+    entity.GetComponent<Component::Transform>().Position = math::vec3(0.0f, -1.5f, 0.0f);
+    entity.AddComponent<Component::Light>(math::vec3(1.0f, 0.1f, 0.1f), 2.0f, 3.0f);
+
+    auto &scriptList = entity.AddComponent<Component::NativeScriptList>();
+    scriptList.AddScript<Oscillate>("Oscillate");
+  }
+
+  {
+    auto entity = m_Scene.CreateEntity("Fountain");
+    entity.GetComponent<Component::Transform>().Position = math::vec3(0.0f, -2.0f, 0.0f);
+    entity.AddComponent<Component::ParticleEmitter>(20000.0f, 2.0f, 6.0f);
+
+    auto &scriptList = entity.AddComponent<Component::NativeScriptList>();
+    scriptList.AddScript<Oscillate>("Oscillate");
+  }
+
+  {
+    // the same z = f(x, y) surface as the cube grid above, as one terrain instead of an entity per sample
+    auto entity = m_Scene.CreateEntity("Terrain");
+    entity.GetComponent<Component::Transform>().Position = math::vec3(-64.0f, -64.0f, -12.0f);
+
+    auto &shaders = entity.GetComponent<Component::ShaderList>();
+    shaders.Add("face-normal");
+
+    auto field = Heightfield::Generate(257, 257, 0.5f, [](float x, float y) { return 4.0f * std::sin(0.15f * x) * std::cos(0.15f * y); });
+    entity.AddComponent<Component::Terrain>(field);
+  }
+
   // {
   //     auto entity = m_Scene.CreateEntity("Living Room");
   //     auto &shaders = entity.GetComponent<Component::ShaderList>();
@@ -300,9 +324,6 @@ void HamLayer::OnAttach()
   //     // mesh.Indicies.Bind();
   //     // mesh.Verticies.Bind();
 
-  //     mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Position));
-  //     mesh.Vertices.DefineAttribute3f(offsetof(Component::VertexData, Normal));
-
   //     // mesh.VAO.Unbind();
   //     // mesh.Verticies.Unbind();
   //     // mesh.Indicies.Unbind();